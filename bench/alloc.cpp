@@ -0,0 +1,5 @@
+#include "harness.hpp"
+
+#include <counting_allocator.hpp>
+
+auto bench::allocations() noexcept -> std::uint64_t { return counting_allocator::allocations(); }
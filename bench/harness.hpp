@@ -0,0 +1,65 @@
+#ifndef UAT_BENCH_HARNESS_HPP
+#define UAT_BENCH_HARNESS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace bench
+{
+
+//! Number of heap allocations performed by the process so far.
+auto allocations() noexcept -> std::uint64_t;
+
+//! Prevents the compiler from optimizing away a value.
+template <typename T> auto keep(const T& value) -> void { asm volatile("" : : "r,m"(value) : "memory"); }
+
+//! Minimal micro-benchmark runner.
+//!
+//! Each benchmark is given a `setup` function that creates a fixture (not measured) and a
+//! `body` function that runs on the fixture and returns the number of operations performed.
+//! The pair is repeated until the time budget is exhausted, and the average time and
+//! number of heap allocations per operation are reported.
+class runner
+{
+public:
+  runner(std::string_view filter, std::chrono::nanoseconds budget) : filter_(filter), budget_(budget)
+  {
+    std::printf("%-56s %14s %14s %12s\n", "benchmark", "ns/op", "allocs/op", "ops");
+  }
+
+  template <typename Setup, typename Body> auto run(const std::string& name, Setup setup, Body body) -> void
+  {
+    if (name.find(filter_) == std::string::npos)
+      return;
+
+    std::uint64_t ops = 0, allocs = 0, repetitions = 0;
+    std::chrono::nanoseconds elapsed{};
+    while (repetitions < 3 || elapsed < budget_) {
+      auto fixture = setup();
+
+      const auto allocs0 = allocations();
+      const auto start = std::chrono::steady_clock::now();
+      ops += body(fixture);
+      elapsed += std::chrono::steady_clock::now() - start;
+      allocs += allocations() - allocs0;
+
+      ++repetitions;
+    }
+
+    const auto n = static_cast<double>(ops ? ops : 1);
+    std::printf("%-56s %14.2f %14.3f %12llu\n", name.c_str(), static_cast<double>(elapsed.count()) / n,
+                static_cast<double>(allocs) / n, static_cast<unsigned long long>(ops));
+    std::fflush(stdout);
+  }
+
+private:
+  std::string filter_;
+  std::chrono::nanoseconds budget_;
+};
+
+} // namespace bench
+
+#endif // UAT_BENCH_HARNESS_HPP
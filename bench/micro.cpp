@@ -0,0 +1,213 @@
+#include "harness.hpp"
+
+#include <uat/simulation.hpp>
+
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+struct cell
+{
+  std::uint32_t id;
+  auto operator==(const cell& other) const noexcept -> bool { return id == other.id; }
+};
+
+} // namespace
+
+template <> struct std::hash<cell>
+{
+  auto operator()(const cell& c) const noexcept -> std::size_t { return std::hash<std::uint32_t>{}(c.id); }
+};
+
+namespace
+{
+
+struct params
+{
+  uat::uint_t regions;
+  uat::uint_t horizon;
+  uat::uint_t agents;
+
+  auto suffix() const -> std::string
+  {
+    return "/r" + std::to_string(regions) + "/h" + std::to_string(horizon) + "/a" + std::to_string(agents);
+  }
+};
+
+//! Agent that queries the status of `regions` x `horizon` permits in each bid phase.
+//! With `distinct`, it places (losing) bids instead, and every bid materializes a new entry in
+//! the book, since status queries never do.
+class scanning_agent : public uat::agent<cell>
+{
+public:
+  scanning_agent(params p, bool distinct, uat::uint_t index) : p_(p), distinct_(distinct), index_(index) {}
+
+  auto bid_phase(uat::uint_t time, uat::bid_fn bid, uat::permit_public_status_fn status, int) -> void override
+  {
+    // Distinct agents use different regions at every step, so no entry is ever found.
+    const auto offset = distinct_ ? (time * p_.agents + index_) * p_.regions : 0;
+    for (uat::uint_t t = time + 1; t <= time + p_.horizon; ++t)
+      for (uat::uint_t r = 0; r < p_.regions; ++r) {
+        const cell c{static_cast<std::uint32_t>(offset + r)};
+        if (distinct_)
+          bench::keep(bid(c, t, 0.0));
+        else
+          bench::keep(status(c, t).index());
+      }
+  }
+
+  auto stop(uat::uint_t, int) -> bool override { return false; }
+
+private:
+  params p_;
+  bool distinct_;
+  uat::uint_t index_;
+};
+
+//! Agent that buys a fresh permit every step, so each step trades one permit per agent.
+class trading_agent : public uat::agent<cell>
+{
+public:
+  explicit trading_agent(uat::uint_t index) : index_(index) {}
+
+  auto bid_phase(uat::uint_t time, uat::bid_fn bid, uat::permit_public_status_fn, int) -> void override
+  {
+    bid(cell{static_cast<std::uint32_t>(index_)}, time + 1, 1.0);
+  }
+
+  auto stop(uat::uint_t, int) -> bool override { return false; }
+
+private:
+  uat::uint_t index_;
+};
+
+class idle_agent : public uat::agent<cell>
+{
+public:
+  auto stop(uat::uint_t, int) -> bool override { return false; }
+};
+
+template <typename Agent, typename... Args> auto make_simulation(uat::uint_t agents, Args... args)
+{
+  auto sim = std::make_unique<uat::simulation<cell>>(uat::simulation_opts_t<cell>{
+    .factory = [=](uat::uint_t t, int) {
+      std::vector<uat::any_agent> result;
+      if (t == 0)
+        for (uat::uint_t i = 0; i < agents; ++i)
+          result.push_back(Agent(args..., i));
+      return result;
+    },
+    .seed = 0});
+  sim->step(); // Create the agents and warm up the book.
+  return sim;
+}
+
+constexpr uat::uint_t steps = 8;
+
+auto book_benchmarks(bench::runner& run, params p) -> void
+{
+  run.run(
+    "book/lookup" + p.suffix(), [&] { return make_simulation<scanning_agent>(p.agents, p, false); },
+    [&](auto& sim) {
+      for (uat::uint_t i = 0; i < steps; ++i)
+        sim->step();
+      return steps * p.agents * p.regions * p.horizon;
+    });
+
+  run.run(
+    "book/materialize" + p.suffix(), [&] { return make_simulation<scanning_agent>(p.agents, p, true); },
+    [&](auto& sim) {
+      for (uat::uint_t i = 0; i < steps; ++i)
+        sim->step();
+      return steps * p.agents * p.regions * p.horizon;
+    });
+
+  run.run(
+    "book/status" + p.suffix(), [&] { return make_simulation<scanning_agent>(p.agents, p, false); },
+    [&](auto& sim) {
+      const auto t0 = sim->time();
+      for (uat::uint_t t = t0; t < t0 + p.horizon; ++t)
+        for (uat::uint_t r = 0; r < p.regions; ++r)
+          bench::keep(sim->status(cell{static_cast<std::uint32_t>(r)}, t).current.index());
+      return p.regions * p.horizon;
+    });
+}
+
+auto dispatch_benchmarks(bench::runner& run, params p) -> void
+{
+  const auto calls = p.agents * p.regions;
+
+  run.run(
+    "dispatch/bid_fn" + p.suffix(), [] { return uat::uint_t{0}; },
+    [&](uat::uint_t& sink) {
+      auto bid = [&sink](uat::region_view, uat::uint_t t, uat::value_t) -> bool { return (sink += t) & 1; };
+      const uat::bid_fn fn(bid);
+      const cell c{0};
+      for (uat::uint_t i = 0; i < calls; ++i)
+        bench::keep(fn(c, i, 1.0));
+      return calls;
+    });
+
+  run.run(
+    "dispatch/any_agent" + p.suffix(),
+    [&] {
+      std::vector<uat::any_agent> agents;
+      for (uat::uint_t i = 0; i < p.agents; ++i)
+        agents.push_back(idle_agent{});
+      return agents;
+    },
+    [&](std::vector<uat::any_agent>& agents) {
+      auto bid = [](uat::region_view, uat::uint_t, uat::value_t) { return false; };
+      auto status = [](uat::region_view, uat::uint_t) -> uat::permit_public_status_t { return {}; };
+      for (auto& agent : agents)
+        agent.bid_phase(0, uat::bid_fn(bid), uat::permit_public_status_fn(status), 0);
+      return p.agents;
+    });
+}
+
+auto engine_benchmarks(bench::runner& run, params p) -> void
+{
+  run.run(
+    "trading" + p.suffix(), [&] { return make_simulation<trading_agent>(p.agents); },
+    [&](auto& sim) {
+      for (uat::uint_t i = 0; i < steps; ++i)
+        sim->step();
+      return steps * p.agents;
+    });
+
+  run.run(
+    "remove_active" + p.suffix(),
+    [&] {
+      uat::agents_private_status_t agents;
+      for (uat::uint_t i = 0; i < p.agents + steps; ++i)
+        agents.insert(idle_agent{});
+      return agents;
+    },
+    [&](auto& agents) {
+      // One agent in the middle stops at every step.
+      for (uat::uint_t i = 0; i < steps; ++i) {
+        const std::size_t position = agents.active_count() / 2;
+        agents.remove_active(std::span{&position, 1});
+      }
+      return steps;
+    });
+}
+
+} // namespace
+
+//! Usage: micro [filter] [budget in ms]
+auto main(int argc, char** argv) -> int
+{
+  bench::runner run(argc > 1 ? argv[1] : "", std::chrono::milliseconds(argc > 2 ? std::atoi(argv[2]) : 200));
+
+  for (const auto p : {params{16, 8, 16}, params{64, 32, 64}, params{256, 64, 64}}) {
+    book_benchmarks(run, p);
+    dispatch_benchmarks(run, p);
+  }
+
+  for (const auto p : {params{0, 0, 100}, params{0, 0, 10'000}, params{0, 0, 1'000'000}})
+    engine_benchmarks(run, p);
+}
@@ -0,0 +1,92 @@
+#include <uat/replay.hpp>
+#include <uat/scenario.hpp>
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+auto peak_rss_mib() -> double
+{
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0; // ru_maxrss is in KiB on Linux.
+}
+
+} // namespace
+
+//! End-to-end benchmark of synthetic scenarios.
+//!
+//! Usage: scenario [--replay] [agents...]
+//!
+//! Agents arrive during 100 steps in a grid whose area grows with the population.  Peak RSS
+//! is a process-wide high-water mark, so populations should be given in increasing order
+//! (or measured in separate processes).
+//!
+//! With `--replay`, the decisions of the agents are recorded and the run is repeated from the
+//! recording, which measures the engine alone (the recording slows down the first run).
+auto main(int argc, char** argv) -> int
+{
+  bool replay = false;
+  std::vector<uat::uint_t> populations;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--replay") == 0)
+      replay = true;
+    else
+      populations.push_back(std::strtoull(argv[i], nullptr, 10));
+  }
+  if (populations.empty())
+    populations = {1'000, 10'000, 100'000, 1'000'000};
+
+  std::printf("%10s %8s %10s %12s %12s %12s", "agents", "grid", "steps", "trades", "steps/s", "peak RSS MiB");
+  std::printf(replay ? " %12s\n" : "\n", "replay st/s");
+
+  for (const auto population : populations) {
+    constexpr uat::uint_t arrival_steps = 100;
+    const auto side = std::max<std::uint32_t>(16, static_cast<std::uint32_t>(std::sqrt(static_cast<double>(population)) / 2));
+
+    const uat::scenario::scenario_opts_t opts{
+      .width = side,
+      .depth = side,
+      .arrival_rate = static_cast<double>(population) / arrival_steps,
+      .arrival_steps = arrival_steps,
+    };
+
+    // Arrivals may pause, so run until the last agent has certainly left.
+    uat::uint_t trades = 0;
+    uat::decision_log<uat::scenario::cell> decisions;
+    const auto make_opts = [&](uat::factory_t factory) -> uat::simulation_opts_t<uat::scenario::cell> {
+      return {
+        .factory = std::move(factory),
+        .stop_criterion = uat::stop_criterion::time_threshold_t{arrival_steps + opts.patience},
+        .trade_callback = [&trades](const uat::trade_info_t<uat::scenario::cell>&) { ++trades; },
+        .seed = 42,
+      };
+    };
+    const auto steps_per_second = [](uat::simulation<uat::scenario::cell>& sim) {
+      const auto start = std::chrono::steady_clock::now();
+      sim.run();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return static_cast<double>(sim.time()) / elapsed.count();
+    };
+
+    auto factory = uat::scenario::make_factory(opts);
+    uat::simulation<uat::scenario::cell> sim(make_opts(replay ? decisions.record(std::move(factory)) : std::move(factory)));
+    const auto rate = steps_per_second(sim);
+
+    std::printf("%10llu %8u %10llu %12llu %12.1f %12.1f", static_cast<unsigned long long>(population), side,
+                static_cast<unsigned long long>(sim.time()), static_cast<unsigned long long>(trades), rate, peak_rss_mib());
+    if (replay) {
+      uat::simulation<uat::scenario::cell> replayed(make_opts(decisions.replay()));
+      std::printf(" %12.1f", steps_per_second(replayed));
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+  }
+}
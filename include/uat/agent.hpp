@@ -6,7 +6,13 @@
 
 #include <uat/permit.hpp>
 
+#include <concepts>
+#include <limits>
+#include <optional>
+#include <ostream>
 #include <span>
+#include <stdexcept>
+#include <type_traits>
 #include <variant>
 
 #include <type_safe/reference.hpp>
@@ -21,6 +27,29 @@ struct trade_value_t
   value_t highest_bid; //!< The highest bid for the permit.
 };
 
+//! \brief Online statistics of trade prices.
+//!
+//! Prices are accumulated one at a time (Welford's algorithm), so every statistic is
+//! available in constant time.  `min` and `max` are infinite while `count` is zero.
+struct market_stats_t
+{
+  uint_t count = 0;                                        //!< Number of trades.
+  value_t last = 0;                                        //!< Price of the most recent trade.
+  value_t mean = 0;                                        //!< Mean price.
+  value_t m2 = 0;                                          //!< Sum of squared deviations from the mean.
+  value_t min = std::numeric_limits<value_t>::infinity();  //!< Lowest price.
+  value_t max = -std::numeric_limits<value_t>::infinity(); //!< Highest price.
+
+  //! Adds the price of a trade.
+  auto add(value_t price) -> void;
+
+  //! Adds the trades of other statistics, which are taken as more recent than these.
+  auto merge(const market_stats_t& other) -> void;
+
+  //! Sample variance of the prices (zero with less than two trades).
+  auto variance() const -> value_t { return count > 1 ? m2 / static_cast<value_t>(count - 1) : 0; }
+};
+
 namespace permit_public_status
 {
 
@@ -36,6 +65,9 @@ struct available
   //! History of trades for the permit.
   //! Each element contains the minimum value and the highest bid.
   std::span<const trade_value_t> trades;
+
+  market_stats_t permit_market; //!< Statistics of all trades of the permit.
+  market_stats_t region_market; //!< Statistics of the recent trades in the region (see `simulation_opts_t::market_window`).
 };
 
 //! Represents the public status of a permit that is owned by the agent.
@@ -48,8 +80,47 @@ struct owned
 using permit_public_status_t =
   std::variant<permit_public_status::unavailable, permit_public_status::available, permit_public_status::owned>;
 
-//! Function reference that allows the agent to bid for a permit.
-using bid_fn = type_safe::function_ref<bool(region_view, uint_t, value_t)>;
+//! A bid for one of the permits of a bundle (see \ref bid_fn).
+struct bundle_item_t
+{
+  region_view location; //!< The region of the permit.
+  uint_t time;          //!< The time of the permit.
+  value_t value;        //!< The value offered for the permit.
+};
+
+//! \brief Function object that allows the agent to bid for permits.
+//!
+//! `bid(location, time, value)` bids for a single permit, and `bid.bundle(items)` bids for a
+//! set of permits atomically: at the end of the bid phase, the agent either wins every permit
+//! of the bundle, paying the value of each item, or none of them.  To win a permit, an item must
+//! be higher than the highest single bid and the minimum value of the permit.  Conflicting
+//! bundles are awarded greedily in decreasing order of total value (ties go to the earliest).
+//!
+//! Both functions return false if the bid is invalid, for example, if a permit is not on sale.
+//! Unlike single bids, a bundle that is accepted is not visible to the other agents.
+class bid_fn
+{
+public:
+  //! Constructs a function that only supports single bids (bundles are always rejected).
+  template <typename F>
+  requires(!std::same_as<std::remove_cvref_t<F>, bid_fn>) bid_fn(F&& single) : single_(std::forward<F>(single))
+  {}
+
+  //! Constructs a function that supports single bids and bundles.
+  template <typename F, typename G>
+  bid_fn(F&& single, G&& bundle) : single_(std::forward<F>(single)), bundle_(std::in_place, std::forward<G>(bundle))
+  {}
+
+  //! Bids for a single permit.
+  auto operator()(region_view location, uint_t time, value_t value) const -> bool { return single_(location, time, value); }
+
+  //! Bids for all permits of a bundle, or none of them.
+  auto bundle(std::span<const bundle_item_t> items) const -> bool { return bundle_ && (*bundle_)(items); }
+
+private:
+  type_safe::function_ref<bool(region_view, uint_t, value_t)> single_;
+  std::optional<type_safe::function_ref<bool(std::span<const bundle_item_t>)>> bundle_;
+};
 
 //! Function reference that allows the agent to ask for a permit.
 using ask_fn = type_safe::function_ref<bool(region_view, uint_t, value_t)>;
@@ -80,6 +151,7 @@ template <region_compatible R> struct agent
   //! is the value the agent is willing to bid for the permit. The function `bid` returns
   //! true if the bidding was successful, and false otherwise.  The function `status`
   //! returns the public status of the permit with type `permit_public_status_t`.
+  //! Permits needed together can be bid for atomically with `bid.bundle` (see \ref bid_fn).
   //!
   //! \note The default behavior of this function is to do nothing.  We suggest
   //!       using `override` to ensure that no function signature mismatch occurs.
@@ -136,6 +208,21 @@ template <region_compatible R> struct agent
   //!
   //! \note This function must be implemented by the agent.
   virtual auto stop(uint_t time, int seed) -> bool = 0;
+
+  //! Writes the internal state of the agent to a simulation checkpoint.
+  //!
+  //! \param os The binary stream of the checkpoint.
+  //!
+  //! Agents opt in to checkpointing by overriding this function.  The written bytes are
+  //! handed back to `simulation_opts_t::agent_deserializer` when the simulation is resumed,
+  //! which must reconstruct an equivalent agent (including its concrete type).
+  //!
+  //! \note The default behavior of this function is to throw `std::logic_error`, i.e.,
+  //!       simulations with agents that do not override it cannot be checkpointed.
+  virtual auto serialize([[maybe_unused]] std::ostream& os) const -> void
+  {
+    throw std::logic_error{"agent does not support serialization"};
+  }
 };
 
 //! \brief Concept that defines the requirements for an agent.
@@ -160,6 +247,8 @@ class any_agent
     virtual auto on_sold(region_view, uint_t, value_t) -> void = 0;
 
     virtual auto stop(uint_t, int) -> bool = 0;
+
+    virtual auto serialize(std::ostream&) const -> void = 0;
   };
 
   //! \private
@@ -191,6 +280,8 @@ class any_agent
 
     auto stop(uint_t t, int seed) -> bool override { return agent_.stop(t, seed); }
 
+    auto serialize(std::ostream& os) const -> void override { agent_.serialize(os); }
+
   private:
     Agent agent_;
   };
@@ -216,6 +307,8 @@ public:
 
   auto stop(uint_t time, int seed) -> bool;
 
+  auto serialize(std::ostream&) const -> void;
+
 private:
   std::unique_ptr<agent_interface> interface_;
 };
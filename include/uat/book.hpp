@@ -0,0 +1,413 @@
+//! \file book.hpp
+//! \brief Defines the private status of permits and the storage of the book.
+
+#ifndef UAT_BOOK_HPP
+#define UAT_BOOK_HPP
+
+#include <uat/agent.hpp>
+
+#include <cassert>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace uat
+{
+
+//! Unique value to represent the absence of an owner.
+constexpr auto no_owner = std::numeric_limits<uint_t>::max();
+
+namespace permit_private_status
+{
+
+//! Represents the private status of a permit that is available for trading.
+struct on_sale
+{
+  uint_t owner = no_owner;          //!< The owner of the permit.
+  value_t min_value = 0.0;          //!< The minimum value (exclusive) that the owner is willing to sell the permit.
+  uint_t highest_bidder = no_owner; //!< The current highest bidder.
+  value_t highest_bid = 0.0;        //!< The current highest bid.
+};
+
+//! Represents the private status of a permit that is not available for trading.
+struct in_use
+{
+  uint_t owner;
+};
+
+//! Represents the private status of a permit that is out of limits (past and future).
+struct out_of_limits
+{};
+
+} // namespace permit_private_status
+
+//! Represents the private status of a permit.
+struct permit_private_status_t
+{
+  //! The current status of the permit.
+  std::variant<permit_private_status::on_sale, permit_private_status::in_use, permit_private_status::out_of_limits> current;
+
+  //! The history of trades involving the permit.
+  std::pmr::vector<trade_value_t> history;
+
+  //! Statistics of the prices in \ref history.
+  market_stats_t market = {};
+};
+
+//! Kind of change of a permit in a step.
+enum class permit_change
+{
+  traded,  //!< The permit was sold (every permit that receives a valid bid is traded in the same step).
+  on_sale, //!< The owner put the permit on sale.
+  expired  //!< The permit left the book because its time is past.
+};
+
+//! A change of a permit in a step.
+template <region_compatible R> struct permit_change_t
+{
+  permit_change kind; //!< What happened to the permit.
+  R location;         //!< The region of the permit.
+  uint_t time;        //!< The time of the permit.
+};
+
+//! \private
+auto write_permit_status(std::ostream&, const permit_private_status_t&) -> void;
+
+//! \private
+auto read_permit_status(std::istream&) -> permit_private_status_t;
+
+//! \brief Customization point that maps regions to dense indices.
+//!
+//! Specializations must provide the static member functions `index(const R&)`, returning a
+//! value in `[0, bound())`, and `bound()`.  When a specialization exists, the simulation
+//! stores the book in flat arrays indexed by time offset and region index, without hashing.
+//! Each time bucket of such a book takes memory proportional to `bound()`, so this is only
+//! advisable for bounded airspaces, such as small grids.
+template <typename R> struct region_index;
+
+//! Concept for regions with a \ref region_index specialization.
+template <typename R>
+concept indexable_region = region_compatible<R> && requires(const R& region)
+{
+  {
+    region_index<R>::index(region)
+    } -> std::convertible_to<std::size_t>;
+  {
+    region_index<R>::bound()
+    } -> std::convertible_to<std::size_t>;
+};
+
+//! \brief Customization point to keep the book sorted by region.
+//!
+//! Specializations deriving from `std::true_type` make the simulation store the permits of
+//! each time step in a search tree ordered by `operator<`, which allows range queries (see
+//! \ref ordered_region_query) to skip regions instead of scanning the whole book.  Lookups
+//! become logarithmic, so this is only advisable when range queries are common.
+template <typename R> struct ordered_book : std::false_type
+{
+};
+
+//! Concept for queries that select a set of regions.
+template <typename Q, typename R>
+concept region_query = requires(const Q& query, const R& region)
+{
+  {
+    query.contains(region)
+    } -> std::convertible_to<bool>;
+};
+
+//! \brief Concept for queries that can be answered by scanning ranges of an ordered book.
+//!
+//! `lower()` and `upper()` are the first and last regions of the query, and `next(region)` is
+//! the first region of the query greater than a region between them that is not in the query.
+template <typename Q, typename R>
+concept ordered_region_query = region_query<Q, R> && requires(const Q& query, const R& region)
+{
+  {
+    query.lower()
+    } -> std::same_as<R>;
+  {
+    query.upper()
+    } -> std::same_as<R>;
+  {
+    query.next(region)
+    } -> std::same_as<R>;
+};
+
+//! \private
+using history_type = decltype(permit_private_status_t::history);
+
+//! \private
+//! Permits of a single time step, stored in a hash table.
+template <region_compatible R> class hashed_bucket
+{
+public:
+  explicit hashed_bucket(std::pmr::memory_resource* resource = std::pmr::new_delete_resource()) : entries_(resource) {}
+
+  auto resource() const -> std::pmr::memory_resource* { return entries_.get_allocator().resource(); }
+
+  auto find(const R& region) const -> const permit_private_status_t*
+  {
+    const auto it = entries_.find(region);
+    return it == entries_.end() ? nullptr : &it->second;
+  }
+
+  auto get(const R& region) -> std::pair<permit_private_status_t&, bool>
+  {
+    auto [it, inserted] = entries_.try_emplace(region, permit_private_status_t{{}, history_type(resource())});
+    return {it->second, inserted};
+  }
+
+  auto size() const -> std::size_t { return entries_.size(); }
+  auto reserve(std::size_t n) -> void { entries_.reserve(n); }
+  auto clear() -> void { entries_.clear(); }
+
+  template <typename F> auto for_each(F&& f) const -> void
+  {
+    for (const auto& [region, status] : entries_)
+      f(region, status);
+  }
+
+private:
+  std::pmr::unordered_map<R, permit_private_status_t> entries_;
+};
+
+//! \private
+//! Permits of a single time step, stored in a search tree ordered by region.
+template <region_compatible R>
+requires std::totally_ordered<R>
+class ordered_bucket
+{
+public:
+  explicit ordered_bucket(std::pmr::memory_resource* resource = std::pmr::new_delete_resource()) : entries_(resource) {}
+
+  auto resource() const -> std::pmr::memory_resource* { return entries_.get_allocator().resource(); }
+
+  auto find(const R& region) const -> const permit_private_status_t*
+  {
+    const auto it = entries_.find(region);
+    return it == entries_.end() ? nullptr : &it->second;
+  }
+
+  auto get(const R& region) -> std::pair<permit_private_status_t&, bool>
+  {
+    auto [it, inserted] = entries_.try_emplace(region, permit_private_status_t{{}, history_type(resource())});
+    return {it->second, inserted};
+  }
+
+  auto size() const -> std::size_t { return entries_.size(); }
+  auto reserve(std::size_t) -> void {}
+  auto clear() -> void { entries_.clear(); }
+
+  template <typename F> auto for_each(F&& f) const -> void
+  {
+    for (const auto& [region, status] : entries_)
+      f(region, status);
+  }
+
+  //! Visits the entries in the query, jumping over the ranges of regions outside of it.
+  template <ordered_region_query<R> Q, typename F> auto for_each_in(const Q& query, F&& f) const -> void
+  {
+    const auto upper = query.upper();
+    auto it = entries_.lower_bound(query.lower());
+    while (it != entries_.end() && !(upper < it->first)) {
+      if (query.contains(it->first)) {
+        f(it->first, it->second);
+        ++it;
+      } else {
+        it = entries_.lower_bound(query.next(it->first));
+      }
+    }
+  }
+
+private:
+  std::pmr::map<R, permit_private_status_t> entries_;
+};
+
+//! \private
+//! Permits of a single time step, stored in a flat array indexed by \ref region_index.
+template <indexable_region R> class dense_bucket
+{
+public:
+  explicit dense_bucket(std::pmr::memory_resource* resource = std::pmr::new_delete_resource())
+    : slots_(resource), used_(resource)
+  {}
+
+  auto resource() const -> std::pmr::memory_resource* { return slots_.get_allocator().resource(); }
+
+  auto find(const R& region) const -> const permit_private_status_t*
+  {
+    if (slots_.empty())
+      return nullptr;
+    const auto& slot = slots_[index(region)];
+    return slot.region ? &slot.status : nullptr;
+  }
+
+  auto get(const R& region) -> std::pair<permit_private_status_t&, bool>
+  {
+    if (slots_.empty()) {
+      slots_.reserve(region_index<R>::bound());
+      for (std::size_t i = 0; i < region_index<R>::bound(); ++i)
+        slots_.push_back({std::nullopt, {{}, history_type(resource())}});
+    }
+
+    const auto i = index(region);
+    auto& slot = slots_[i];
+    if (slot.region)
+      return {slot.status, false};
+
+    slot.region.emplace(region);
+    used_.push_back(i);
+    return {slot.status, true};
+  }
+
+  auto size() const -> std::size_t { return used_.size(); }
+  auto reserve(std::size_t n) -> void { used_.reserve(n); }
+
+  //! Only the used slots are reset, and their histories keep their capacity.
+  auto clear() -> void
+  {
+    for (const auto i : used_) {
+      auto& slot = slots_[i];
+      slot.region.reset();
+      slot.status.current = permit_private_status::on_sale{};
+      slot.status.history.clear();
+      slot.status.market = {};
+    }
+    used_.clear();
+  }
+
+  //! Entries are visited in the order they were created.
+  template <typename F> auto for_each(F&& f) const -> void
+  {
+    for (const auto i : used_)
+      f(*slots_[i].region, slots_[i].status);
+  }
+
+private:
+  static auto index(const R& region) -> std::size_t
+  {
+    const std::size_t i = region_index<R>::index(region);
+    assert(i < region_index<R>::bound());
+    return i;
+  }
+
+  struct slot
+  {
+    std::optional<R> region;
+    permit_private_status_t status;
+  };
+
+  std::pmr::vector<slot> slots_;
+  std::pmr::vector<std::size_t> used_;
+};
+
+//! \private
+template <region_compatible R> struct book_bucket
+{
+  using type = hashed_bucket<R>;
+};
+
+//! \private
+template <indexable_region R> struct book_bucket<R>
+{
+  using type = dense_bucket<R>;
+};
+
+//! \private
+template <region_compatible R>
+requires(ordered_book<R>::value && !indexable_region<R>) struct book_bucket<R>
+{
+  using type = ordered_bucket<R>;
+};
+
+//! \private
+//! Visits the entries of a bucket whose regions are in the query.
+template <typename Bucket, typename Q, typename F> auto for_each_in(const Bucket& bucket, const Q& query, F&& f) -> void
+{
+  if constexpr (requires { bucket.for_each_in(query, f); }) {
+    bucket.for_each_in(query, f);
+  } else {
+    bucket.for_each([&](const auto& region, const permit_private_status_t& status) {
+      if (query.contains(region))
+        f(region, status);
+    });
+  }
+}
+
+//! \private
+template <region_compatible R> using book_bucket_t = typename book_bucket<R>::type;
+
+//! \private
+template <region_compatible R> using book_data_t = std::pmr::deque<book_bucket_t<R>>;
+
+//! \private
+//! Cleared buckets kept by the calling thread so that later simulations on the same thread reuse
+//! their storage instead of allocating new ones.  Threads only keep buckets after calling
+//! \ref enable_bucket_recycling (as the workers of \ref simulate_ensemble do), and only buckets
+//! using the global heap, since other memory resources may not outlive the simulation.
+template <region_compatible R> struct bucket_recycler
+{
+  bool enabled = false;
+  std::vector<book_bucket_t<R>> buckets;
+};
+
+//! \private
+template <region_compatible R> auto recycled_buckets() -> bucket_recycler<R>&
+{
+  thread_local bucket_recycler<R> recycler;
+  return recycler;
+}
+
+//! Makes the simulations that end on the calling thread keep their book buckets for the next
+//! simulation on the thread, up to the size of the book of the last one.
+template <region_compatible R> auto enable_bucket_recycling() -> void { recycled_buckets<R>().enabled = true; }
+
+//! Frees the book buckets kept by the calling thread (see \ref enable_bucket_recycling).
+template <region_compatible R> auto release_recycled_buckets() -> void
+{
+  auto& buckets = recycled_buckets<R>().buckets;
+  buckets.clear();
+  buckets.shrink_to_fit();
+}
+
+//! \private
+template <region_compatible R> auto acquire_bucket(std::pmr::memory_resource* resource) -> book_bucket_t<R>
+{
+  auto& buckets = recycled_buckets<R>().buckets;
+  if (buckets.empty() || resource != std::pmr::new_delete_resource())
+    return book_bucket_t<R>(resource);
+  auto bucket = std::move(buckets.back());
+  buckets.pop_back();
+  return bucket;
+}
+
+//! \private
+template <region_compatible R> auto release_bucket(book_bucket_t<R>&& bucket) -> void
+{
+  auto& recycler = recycled_buckets<R>();
+  if (!recycler.enabled || bucket.resource() != std::pmr::new_delete_resource())
+    return;
+  bucket.clear();
+  recycler.buckets.push_back(std::move(bucket));
+}
+
+//! \private
+//! Keeps at most `count` recycled buckets on the calling thread.
+template <region_compatible R> auto trim_recycled_buckets(std::size_t count) -> void
+{
+  auto& buckets = recycled_buckets<R>().buckets;
+  if (buckets.size() > count)
+    buckets.erase(buckets.begin(), buckets.end() - static_cast<std::ptrdiff_t>(count));
+}
+
+} // namespace uat
+
+#endif // UAT_BOOK_HPP
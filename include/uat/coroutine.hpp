@@ -0,0 +1,255 @@
+//! \file coroutine.hpp
+//! \brief Defines an adapter to write agents as coroutines.
+
+#ifndef UAT_COROUTINE_HPP
+#define UAT_COROUTINE_HPP
+
+#include <uat/agent.hpp>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace uat
+{
+
+//! \brief Pool from which the frames of coroutine agents are allocated.
+//!
+//! Frames are grouped in size classes and carved from large contiguous chunks.  Released
+//! frames are kept in per-class free lists and reused by later coroutines, so the memory
+//! used by suspended agents is bounded by the peak number of agents alive at the same time.
+//! Frames larger than the biggest size class fall back to the global allocator.
+class frame_pool
+{
+public:
+  //! Allocates memory for a coroutine frame.
+  static auto allocate(std::size_t size) -> void*;
+
+  //! Releases memory previously returned by \ref allocate with the same size.
+  static auto deallocate(void* ptr, std::size_t size) noexcept -> void;
+
+  //! Number of bytes reserved by the pool.
+  static auto reserved() noexcept -> std::size_t;
+};
+
+//! A permit bought or sold by a coroutine agent.
+template <region_compatible R> struct trade_result_t
+{
+  R location;    //!< The region of the permit.
+  uint_t time;   //!< The time of the permit.
+  value_t value; //!< The value paid or received for the permit.
+};
+
+//! Information received by a coroutine agent when it resumes in the bid phase.
+template <region_compatible R> struct bid_context_t
+{
+  uint_t time;                                //!< The current time step.
+  bid_fn bid;                                 //!< Function to bid for a permit.
+  permit_public_status_fn status;             //!< Function to query the public status of a permit.
+  int seed;                                   //!< A random seed.
+  std::span<const trade_result_t<R>> bought; //!< Permits bought since the agent last resumed.
+  std::span<const trade_result_t<R>> sold;   //!< Permits sold since the agent last resumed.
+};
+
+//! Information received by a coroutine agent when it resumes in the ask phase.
+template <region_compatible R> struct ask_context_t
+{
+  uint_t time;                                //!< The current time step.
+  ask_fn ask;                                 //!< Function to ask for a permit.
+  permit_public_status_fn status;             //!< Function to query the public status of a permit.
+  int seed;                                   //!< A random seed.
+  std::span<const trade_result_t<R>> bought; //!< Permits bought since the agent last resumed.
+  std::span<const trade_result_t<R>> sold;   //!< Permits sold since the agent last resumed.
+};
+
+//! Tag awaited by a coroutine agent to suspend until the next bid phase.
+inline constexpr struct next_bid_t
+{
+} next_bid;
+
+//! Tag awaited by a coroutine agent to suspend until the next ask phase.
+inline constexpr struct next_ask_t
+{
+} next_ask;
+
+//! \brief Return type of coroutines that implement agents.
+//!
+//! Inside the coroutine, `co_await uat::next_bid` suspends until the next bid phase and
+//! returns a \ref bid_context_t, while `co_await uat::next_ask` suspends until the next
+//! ask phase and returns an \ref ask_context_t.  Both contexts carry the trades involving
+//! the agent since it last resumed.  The agent stops once the coroutine returns.
+//!
+//! The functions in the contexts are only valid until the coroutine suspends again.
+template <region_compatible R> class agent_task
+{
+public:
+  //! \private
+  class promise_type
+  {
+    friend class agent_task;
+
+    enum class phase
+    {
+      start,
+      bid,
+      ask
+    };
+
+    template <typename Context> struct awaiter
+    {
+      promise_type& promise;
+      std::optional<Context>& context;
+      phase waiting;
+
+      auto await_ready() const noexcept -> bool { return context.has_value(); }
+      auto await_suspend(std::coroutine_handle<>) noexcept -> void { promise.waiting_ = waiting; }
+      auto await_resume() -> Context
+      {
+        auto result = std::move(*context);
+        context.reset();
+        return result;
+      }
+    };
+
+  public:
+    static auto operator new(std::size_t size) -> void* { return frame_pool::allocate(size); }
+    static auto operator delete(void* ptr, std::size_t size) noexcept -> void { frame_pool::deallocate(ptr, size); }
+
+    auto get_return_object() -> agent_task { return agent_task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+
+    auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+    auto final_suspend() noexcept -> std::suspend_always { return {}; }
+
+    auto return_void() noexcept -> void {}
+    auto unhandled_exception() noexcept -> void { error_ = std::current_exception(); }
+
+    auto await_transform(next_bid_t) -> awaiter<bid_context_t<R>> { return {*this, bid_, phase::bid}; }
+    auto await_transform(next_ask_t) -> awaiter<ask_context_t<R>> { return {*this, ask_, phase::ask}; }
+
+  private:
+    phase waiting_ = phase::start;
+    std::optional<bid_context_t<R>> bid_;
+    std::optional<ask_context_t<R>> ask_;
+    std::vector<trade_result_t<R>> bought_, sold_;
+    std::exception_ptr error_;
+  };
+
+  agent_task(const agent_task&) = delete;
+  agent_task(agent_task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  auto operator=(const agent_task&) -> agent_task& = delete;
+  auto operator=(agent_task&& other) noexcept -> agent_task&
+  {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+
+  ~agent_task()
+  {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  //! Resumes the coroutine if it is waiting for the bid phase.
+  auto bid_phase(uint_t time, bid_fn bid, permit_public_status_fn status, int seed) -> void
+  {
+    auto& promise = handle_.promise();
+    promise.bid_.emplace(bid_context_t<R>{time, bid, status, seed, promise.bought_, promise.sold_});
+    resume_if(promise_type::phase::bid);
+    promise.bid_.reset();
+  }
+
+  //! Resumes the coroutine if it is waiting for the ask phase.
+  auto ask_phase(uint_t time, ask_fn ask, permit_public_status_fn status, int seed) -> void
+  {
+    auto& promise = handle_.promise();
+    promise.ask_.emplace(ask_context_t<R>{time, ask, status, seed, promise.bought_, promise.sold_});
+    resume_if(promise_type::phase::ask);
+    promise.ask_.reset();
+  }
+
+  //! Records a permit bought by the agent.
+  auto on_bought(const R& location, uint_t time, value_t value) -> void
+  {
+    handle_.promise().bought_.push_back({location, time, value});
+  }
+
+  //! Records a permit sold by the agent.
+  auto on_sold(const R& location, uint_t time, value_t value) -> void
+  {
+    handle_.promise().sold_.push_back({location, time, value});
+  }
+
+  //! Whether the coroutine has returned.
+  auto done() const -> bool { return handle_.done(); }
+
+private:
+  explicit agent_task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  auto resume_if(typename promise_type::phase waiting) -> void
+  {
+    auto& promise = handle_.promise();
+    if (handle_.done() || (promise.waiting_ != waiting && promise.waiting_ != promise_type::phase::start))
+      return;
+
+    handle_.resume();
+
+    // Trades are delivered exactly once, to the phase that resumed the coroutine.
+    promise.bought_.clear();
+    promise.sold_.clear();
+
+    if (promise.error_)
+      std::rethrow_exception(std::exchange(promise.error_, nullptr));
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+//! \brief Agent whose behavior is implemented by a coroutine.
+//!
+//! Example:
+//! \code
+//! auto drone(Point goal) -> uat::agent_task<Point> {
+//!   while (true) {
+//!     auto [time, bid, status, seed, bought, sold] = co_await uat::next_bid;
+//!     bid(goal, time + 1, 1.0);
+//!     auto ask = co_await uat::next_ask;
+//!     if (!ask.bought.empty())
+//!       co_return; // stop
+//!   }
+//! }
+//!
+//! agents.push_back(uat::coroutine_agent<Point>(drone({0, 0})));
+//! \endcode
+template <region_compatible R> class coroutine_agent : public agent<R>
+{
+public:
+  //! Constructs an agent from a coroutine.
+  explicit coroutine_agent(agent_task<R> task) : task_(std::move(task)) {}
+
+  auto bid_phase(uint_t time, bid_fn bid, permit_public_status_fn status, int seed) -> void override
+  {
+    task_.bid_phase(time, bid, status, seed);
+  }
+
+  auto ask_phase(uint_t time, ask_fn ask, permit_public_status_fn status, int seed) -> void override
+  {
+    task_.ask_phase(time, ask, status, seed);
+  }
+
+  auto on_bought(const R& region, uint_t time, value_t value) -> void override { task_.on_bought(region, time, value); }
+
+  auto on_sold(const R& region, uint_t time, value_t value) -> void override { task_.on_sold(region, time, value); }
+
+  auto stop(uint_t, int) -> bool override { return task_.done(); }
+
+private:
+  agent_task<R> task_;
+};
+
+} // namespace uat
+
+#endif // UAT_COROUTINE_HPP
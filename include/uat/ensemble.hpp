@@ -0,0 +1,88 @@
+//! \file ensemble.hpp
+//! \brief Defines a runner for ensembles of independent simulations.
+
+#ifndef UAT_ENSEMBLE_HPP
+#define UAT_ENSEMBLE_HPP
+
+#include <uat/simulation.hpp>
+#include <uat/thread_pool.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace uat
+{
+
+//! Options to configure an ensemble of independent simulations.
+struct ensemble_opts_t
+{
+  uint_t runs = 1;                    //!< Number of independent simulations.
+  std::optional<uint_t> seed;         //!< Seed from which the seed of each run is derived.
+  std::optional<std::size_t> threads; //!< Number of worker threads (defaults to the hardware concurrency).
+};
+
+//! Derives the seed of each run of an ensemble.
+//!
+//! The seeds depend only on `seed` and `runs`, so an ensemble is reproducible regardless of
+//! the number of threads.  If `seed` is empty, a random one is drawn.
+auto ensemble_seeds(uint_t runs, std::optional<uint_t> seed) -> std::vector<uint_t>;
+
+//! Runs independent simulations in parallel and reduces their results.
+//!
+//! \param pool The thread pool that executes the runs.
+//! \param opts Options to configure the ensemble.
+//! \param setup Function `(uint_t seed, T& result) -> simulation_opts_t<R>` that configures a run.
+//! \param reduce Function `(T& accumulated, T&& result)` that merges the result of a run.
+//! \param init Initial value of the reduction.
+//!
+//! Each run starts with a value-initialized `T` that the callbacks returned by `setup` may
+//! capture by reference; once the simulation finishes, the value is handed to `reduce`.
+//! The seed of the returned options is overridden by the seed of the run.  Results are
+//! reduced in run order, so the outcome is deterministic given `opts.seed`.
+//!
+//! Book buckets released by a simulation are recycled by later simulations on the same
+//! worker, so reusing a pool across ensembles avoids warming up the allocator again.  Each
+//! worker keeps at most the book of its last run, until the pool is destroyed or the worker
+//! calls \ref release_recycled_buckets.
+//!
+//! \note `setup` is invoked concurrently from the workers of the pool.
+template <region_compatible R, typename T, typename Setup, typename Reduce>
+requires std::default_initializable<T> && std::invocable<Reduce&, T&, T&&> &&
+  std::is_invocable_r_v<simulation_opts_t<R>, const Setup&, uint_t, T&>
+auto simulate_ensemble(thread_pool& pool, const ensemble_opts_t& opts, const Setup& setup, Reduce reduce, T init = {}) -> T
+{
+  const auto seeds = ensemble_seeds(opts.runs, opts.seed);
+  std::vector<std::optional<T>> results(opts.runs);
+
+  for (uint_t run = 0; run < opts.runs; ++run) {
+    pool.submit([&, run] {
+      enable_bucket_recycling<R>();
+      T result{};
+      auto sim_opts = setup(seeds[run], result);
+      sim_opts.seed = seeds[run];
+      simulate<R>(sim_opts);
+      results[run].emplace(std::move(result));
+    });
+  }
+  pool.wait();
+
+  for (auto& result : results)
+    reduce(init, std::move(*result));
+  return init;
+}
+
+//! Runs independent simulations in parallel and reduces their results.
+//!
+//! Same as above, but using a thread pool created for this ensemble with `opts.threads` workers.
+template <region_compatible R, typename T, typename Setup, typename Reduce>
+requires std::default_initializable<T> && std::invocable<Reduce&, T&, T&&> &&
+  std::is_invocable_r_v<simulation_opts_t<R>, const Setup&, uint_t, T&>
+auto simulate_ensemble(const ensemble_opts_t& opts, const Setup& setup, Reduce reduce, T init = {}) -> T
+{
+  thread_pool pool(opts.threads ? *opts.threads : std::thread::hardware_concurrency());
+  return simulate_ensemble<R>(pool, opts, setup, std::move(reduce), std::move(init));
+}
+
+} // namespace uat
+
+#endif // UAT_ENSEMBLE_HPP
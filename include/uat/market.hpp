@@ -0,0 +1,145 @@
+//! \file market.hpp
+//! \brief Defines statistics of the recent trades in each region.
+
+#ifndef UAT_MARKET_HPP
+#define UAT_MARKET_HPP
+
+#include <uat/agent.hpp>
+#include <uat/serialization.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <istream>
+#include <memory_resource>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace uat
+{
+
+//! \brief Statistics of the trades in each region over a sliding window of time steps.
+//!
+//! The simulation records every trade in the step it happens (see `simulation_opts_t::market_window`),
+//! and agents receive the statistics of a region in `permit_public_status::available`.  Trades
+//! are grouped by step, so the statistics of a region are updated in constant time per trade, and
+//! in time proportional to the window when its oldest step leaves the window.  Regions without
+//! trades in the window take no memory.
+template <region_compatible R> class region_market
+{
+public:
+  //! Constructs empty statistics over windows of `window` steps (zero disables them).
+  explicit region_market(uint_t window, std::pmr::memory_resource* resource = std::pmr::new_delete_resource())
+    : window_(window), regions_(resource), expirations_(resource)
+  {}
+
+  //! Records the price of a trade of a permit of the region in time step `now`.
+  auto record(const R& region, uint_t now, value_t price) -> void
+  {
+    if (window_ == 0)
+      return;
+    auto it = regions_.find(region);
+    if (it == regions_.end())
+      it = regions_.emplace(region, entry{steps_type(resource()), {}}).first;
+    auto& [steps, total] = it->second;
+    if (steps.empty() || steps.back().first != now) {
+      steps.emplace_back(now, market_stats_t{});
+      expirations_.emplace_back(now, region);
+    }
+    steps.back().second.add(price);
+    total.add(price);
+  }
+
+  //! Drops the trades that left the window ending at time step `now`.
+  auto advance(uint_t now) -> void
+  {
+    while (!expirations_.empty() && expirations_.front().first + window_ <= now) {
+      const auto it = regions_.find(expirations_.front().second);
+      expirations_.pop_front();
+      auto& [steps, total] = it->second;
+      steps.pop_front();
+      if (steps.empty()) {
+        regions_.erase(it);
+        continue;
+      }
+      total = {};
+      for (const auto& [step, stats] : steps)
+        total.merge(stats);
+    }
+  }
+
+  //! Statistics of the trades in the region in the window.
+  auto stats(const R& region) const -> const market_stats_t&
+  {
+    static const market_stats_t empty{};
+    const auto it = regions_.find(region);
+    return it == regions_.end() ? empty : it->second.total;
+  }
+
+  //! Drops every trade.
+  auto clear() -> void
+  {
+    regions_.clear();
+    expirations_.clear();
+  }
+
+  //! Number of regions with trades in the window.
+  auto size() const -> std::size_t { return regions_.size(); }
+
+  //! Writes the statistics to a binary stream.
+  auto save(std::ostream& os) const -> void requires serializable_region<R>
+  {
+    write_binary(os, regions_.size());
+    for (const auto& [region, entry] : regions_) {
+      region_serializer<R>::write(os, region);
+      write_binary(os, entry.total);
+      write_binary(os, entry.steps.size());
+      for (const auto& [step, stats] : entry.steps) {
+        write_binary(os, step);
+        write_binary(os, stats);
+      }
+    }
+  }
+
+  //! Restores the statistics from a binary stream written by \ref save.
+  auto load(std::istream& is) -> void requires serializable_region<R>
+  {
+    clear();
+    std::vector<std::pair<uint_t, R>> expirations;
+    const auto count = read_binary<std::size_t>(is);
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto region = region_serializer<R>::read(is);
+      auto& [steps, total] = regions_.emplace(region, entry{steps_type(resource()), {}}).first->second;
+      total = read_binary<market_stats_t>(is);
+      steps.resize(read_binary<std::size_t>(is));
+      for (auto& [step, stats] : steps) {
+        step = read_binary<uint_t>(is);
+        stats = read_binary<market_stats_t>(is);
+        expirations.emplace_back(step, region);
+      }
+    }
+    // Regions leave the window independently, so only the order of the steps matters.
+    std::ranges::stable_sort(expirations, {}, &std::pair<uint_t, R>::first);
+    expirations_.assign(expirations.begin(), expirations.end());
+  }
+
+private:
+  using steps_type = std::pmr::deque<std::pair<uint_t, market_stats_t>>;
+
+  struct entry
+  {
+    steps_type steps;     // Statistics of each step with trades, oldest first.
+    market_stats_t total; // Statistics of the whole window.
+  };
+
+  auto resource() const -> std::pmr::memory_resource* { return regions_.get_allocator().resource(); }
+
+  uint_t window_;
+  std::pmr::unordered_map<R, entry> regions_;
+  std::pmr::deque<std::pair<uint_t, R>> expirations_; // Steps with trades of each region, oldest first.
+};
+
+} // namespace uat
+
+#endif // UAT_MARKET_HPP
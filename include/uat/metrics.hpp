@@ -0,0 +1,87 @@
+//! \file metrics.hpp
+//! \brief Defines the per-step metrics collected by the simulation engine.
+
+#ifndef UAT_METRICS_HPP
+#define UAT_METRICS_HPP
+
+#include <uat/type.hpp>
+
+#include <chrono>
+
+namespace uat
+{
+
+//! Whether the engine collects metrics (enabled by the CMake option `UAT_ENABLE_METRICS`).
+//!
+//! When disabled, the counters and timers below are never updated and all instrumentation
+//! compiles to nothing.
+#ifdef UAT_ENABLE_METRICS
+inline constexpr bool metrics_enabled = true;
+#else
+inline constexpr bool metrics_enabled = false;
+#endif
+
+//! Counters and timers of a single simulation step.
+struct simulation_metrics_t
+{
+  uint_t agents_created = 0;        //!< Agents generated by the factory.
+  uint_t agents_active = 0;         //!< Active agents at the end of the step.
+  uint_t agents_stopped = 0;        //!< Agents removed from the simulation.
+  uint_t bids_accepted = 0;         //!< Bids that became the highest bid for a permit.
+  uint_t bids_rejected = 0;         //!< Bids that were invalid or not higher than the current ones.
+  uint_t bundles_accepted = 0;      //!< Valid bundles of bids, awarded or not.
+  uint_t bundles_rejected = 0;      //!< Invalid bundles of bids.
+  uint_t bundles_awarded = 0;       //!< Bundles whose permits were all won.
+  uint_t asks_accepted = 0;         //!< Permits put on sale.
+  uint_t asks_rejected = 0;         //!< Asks for permits not owned by the agent.
+  uint_t trades = 0;                //!< Permits traded.
+  uint_t book_lookups = 0;          //!< Accesses to the book within the time limits.
+  uint_t book_materializations = 0; //!< Book accesses that created a new entry.
+  uint_t book_buckets = 0;          //!< Time buckets in the book at the end of the step.
+  uint_t book_entries = 0;          //!< Entries in the book at the end of the step.
+  uint_t max_bucket_size = 0;       //!< Entries in the largest bucket at the end of the step.
+
+  std::chrono::nanoseconds factory_time{}; //!< Time spent generating agents.
+  std::chrono::nanoseconds bid_time{};     //!< Time spent in the bid phase.
+  std::chrono::nanoseconds trading_time{}; //!< Time spent trading permits.
+  std::chrono::nanoseconds ask_time{};     //!< Time spent in the ask phase.
+  std::chrono::nanoseconds stop_time{};    //!< Time spent checking which agents stop.
+};
+
+//! \private
+constexpr auto count_metric([[maybe_unused]] uint_t& counter, [[maybe_unused]] uint_t n = 1) noexcept -> void
+{
+  if constexpr (metrics_enabled)
+    counter += n;
+}
+
+//! \private
+//! Adds the lifetime of the object to a timer when metrics are enabled.
+class scoped_timer
+{
+public:
+  explicit scoped_timer([[maybe_unused]] std::chrono::nanoseconds& timer) noexcept
+  {
+    if constexpr (metrics_enabled) {
+      timer_ = &timer;
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  scoped_timer(const scoped_timer&) = delete;
+  auto operator=(const scoped_timer&) -> scoped_timer& = delete;
+
+  ~scoped_timer()
+  {
+    if constexpr (metrics_enabled)
+      *timer_ += std::chrono::steady_clock::now() - start_;
+  }
+
+private:
+  std::chrono::nanoseconds* timer_ = nullptr;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace uat
+
+#endif // UAT_METRICS_HPP
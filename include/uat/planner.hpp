@@ -0,0 +1,166 @@
+//! \file planner.hpp
+//! \brief Defines a space-time route planner over the public status of permits.
+
+#ifndef UAT_PLANNER_HPP
+#define UAT_PLANNER_HPP
+
+#include <uat/agent.hpp>
+
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace uat
+{
+
+//! Options of \ref plan_route.
+struct planner_opts_t
+{
+  uint_t earliest_departure;               //!< First time step at which the route may start.
+  uint_t latest_departure;                 //!< Last time step at which the route may start.
+  uint_t max_duration = 64;                //!< Maximum number of permits (time steps) in a route.
+  uint_t max_expansions = uint_t{1} << 16; //!< Maximum number of permits expanded by the search.
+};
+
+//! A route found by \ref plan_route.
+template <region_compatible R> struct route_plan_t
+{
+  std::vector<permit<R>> permits; //!< The permits along the route, one per time step.
+  value_t cost;                   //!< The total cost of the route.
+};
+
+//! \brief Default cost model of \ref plan_route.
+//!
+//! Each permit costs its minimum value (zero for owned permits) plus a fixed cost per step, so
+//! that shorter routes are preferred among free ones.
+struct min_value_cost
+{
+  value_t step_cost = 1.0; //!< Cost of every time step of the route.
+
+  template <region_compatible R> auto operator()(const R&, uint_t, const permit_public_status_t& status) const -> value_t
+  {
+    const auto* available = std::get_if<permit_public_status::available>(&status);
+    return step_cost + (available ? available->min_value : 0.0);
+  }
+};
+
+//! \brief Finds the cheapest route between two regions with a space-time A* search.
+//!
+//! \param status The public status function received by the agent.
+//! \param from The first region of the route.
+//! \param to The last region of the route.
+//! \param opts Departure window and search limits.
+//! \param neighbors Function returning a range with the regions reachable from a region in one
+//!                  time step; include the region itself to allow hovering.
+//! \param cost Function `(region, time, status) -> value_t` giving the cost of a permit that is
+//!             available or owned; return infinity to forbid it.
+//! \param heuristic Function `(region, to) -> value_t` that never overestimates the cost from a
+//!                  region to the destination (zero makes the search a Dijkstra search).
+//!
+//! The route holds one permit per time step, starting at some departure in the window.  Only
+//! available and owned permits are considered; others are pruned without being expanded.  The
+//! status of each permit is queried at most once, and the queries never create entries in the
+//! book.  Returns nothing if no route is found within the limits.
+template <region_compatible R, typename Neighbors, typename Cost, typename Heuristic>
+requires std::invocable<Neighbors&, const R&> && std::invocable<Heuristic&, const R&, const R&>
+auto plan_route(permit_public_status_fn status, const R& from, const R& to, const planner_opts_t& opts, Neighbors&& neighbors,
+                Cost&& cost, Heuristic&& heuristic) -> std::optional<route_plan_t<R>>
+{
+  constexpr auto none = std::numeric_limits<std::size_t>::max();
+  constexpr auto infinity = std::numeric_limits<value_t>::infinity();
+
+  struct node
+  {
+    permit<R> key;
+    uint_t departure;
+    value_t step;             // Cost of this permit, infinity if it cannot be used.
+    value_t total = infinity; // Cost of the best route found to this permit.
+    std::size_t parent = none;
+  };
+
+  struct entry
+  {
+    value_t estimate;
+    value_t total;
+    std::size_t order; // Ties are broken by insertion order, so that searches are deterministic.
+    std::size_t node;
+    auto operator>(const entry& other) const -> bool
+    {
+      return estimate != other.estimate ? estimate > other.estimate : order > other.order;
+    }
+  };
+
+  std::vector<node> nodes;
+  std::unordered_map<permit<R>, std::size_t> index;
+  std::priority_queue<entry, std::vector<entry>, std::greater<>> open;
+  std::size_t pushed = 0;
+
+  // Permits are probed once, when first reached, and unusable ones are never expanded.
+  const auto probe = [&](const R& region, uint_t time, uint_t departure) -> std::size_t {
+    const auto [it, inserted] = index.try_emplace(permit<R>{region, time}, nodes.size());
+    if (inserted) {
+      const auto s = status(region, time);
+      const auto usable = !std::holds_alternative<permit_public_status::unavailable>(s);
+      nodes.push_back({{region, time}, departure, usable ? static_cast<value_t>(cost(region, time, s)) : infinity});
+    }
+    return it->second;
+  };
+
+  const auto relax = [&](std::size_t i, std::size_t parent, value_t base) {
+    auto& n = nodes[i];
+    if (n.step == infinity || base + n.step >= n.total)
+      return;
+    n.total = base + n.step;
+    n.parent = parent;
+    if (parent != none)
+      n.departure = nodes[parent].departure;
+    open.push({n.total + static_cast<value_t>(heuristic(n.key.location, to)), n.total, pushed++, i});
+  };
+
+  for (auto t = opts.earliest_departure; t <= opts.latest_departure; ++t)
+    relax(probe(from, t, t), none, 0.0);
+
+  for (uint_t expansions = 0; !open.empty() && expansions < opts.max_expansions;) {
+    const auto [estimate, total, order, i] = open.top();
+    open.pop();
+    if (total > nodes[i].total)
+      continue; // A cheaper route to this permit was found after the entry was pushed.
+
+    if (nodes[i].key.location == to) {
+      route_plan_t<R> plan{{}, nodes[i].total};
+      for (auto j = i; j != none; j = nodes[j].parent)
+        plan.permits.push_back(nodes[j].key);
+      std::ranges::reverse(plan.permits);
+      return plan;
+    }
+
+    ++expansions;
+    const auto [time, departure] = std::pair{nodes[i].key.time, nodes[i].departure};
+    if (time + 1 - departure >= opts.max_duration)
+      continue;
+    const auto location = nodes[i].key.location;
+    for (const R& next : neighbors(location))
+      relax(probe(next, time + 1, departure), i, total);
+  }
+
+  return std::nullopt;
+}
+
+//! Finds the cheapest route with \ref plan_route and the default cost model.
+template <region_compatible R, typename Neighbors, typename Heuristic>
+auto plan_route(permit_public_status_fn status, const R& from, const R& to, const planner_opts_t& opts, Neighbors&& neighbors,
+                Heuristic&& heuristic) -> std::optional<route_plan_t<R>>
+{
+  return plan_route(status, from, to, opts, neighbors, min_value_cost{}, heuristic);
+}
+
+} // namespace uat
+
+#endif // UAT_PLANNER_HPP
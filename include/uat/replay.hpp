@@ -0,0 +1,342 @@
+//! \file replay.hpp
+//! \brief Defines the recording of agent decisions and their replay without agent code.
+
+#ifndef UAT_REPLAY_HPP
+#define UAT_REPLAY_HPP
+
+#include <uat/simulation.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace uat
+{
+
+//! Kinds of entries in a \ref decision_log.
+enum class decision : std::uint8_t
+{
+  bid_phase,   //!< The agent entered the bid phase at `time`.
+  ask_phase,   //!< The agent entered the ask phase at `time`.
+  status,      //!< The agent queried the public status of a permit.
+  bid,         //!< The agent bid for a permit.
+  bundle_item, //!< A permit of the next bundle.
+  bundle,      //!< The agent bid for the bundle made of the preceding items.
+  ask,         //!< The agent asked for a permit.
+  stop,        //!< The agent stopped at `time`.
+  keep         //!< The agent did not stop at `time`.
+};
+
+//! An entry in the decisions of an agent.
+struct decision_t
+{
+  decision kind;        //!< What the agent did.
+  std::uint32_t region; //!< Index of the region in `decision_log::regions()` (calls on permits only).
+  uint_t time;          //!< The time of the permit, or the current time step for phases and stops.
+  value_t value;        //!< The value of bids and asks.
+};
+
+//! \brief Recorded decisions of every agent of a simulation.
+//!
+//! A log records the calls made by agents to the functions they receive (`bid`, `bid.bundle`,
+//! `ask` and `status`) and the results of `agent::stop`, in order.  Replaying the log feeds the
+//! same calls to the simulation, so that the book, trading and bookkeeping can be benchmarked
+//! with no agent code.  As the simulation is deterministic, a replay with the same options
+//! (except for the factory) reproduces the recorded run.
+//!
+//! Example:
+//! \code
+//! uat::decision_log<Point> log;
+//! uat::simulate<Point>({.factory = log.record(factory), .seed = 42});
+//! uat::simulate<Point>({.factory = log.replay(), .seed = 42}); // No agent code runs.
+//! \endcode
+//!
+//! The log must outlive the simulations.  Recording agents cannot be checkpointed.  They may
+//! run on the workers of `simulation_opts_t::pool`: each agent only appends to its own
+//! decisions, and regions are interned under a lock.  The indices of the regions then depend
+//! on the scheduling of the workers, but the replayed calls do not.
+template <region_compatible R> class decision_log
+{
+public:
+  //! Wraps a factory so that the decisions of the agents it creates are recorded.
+  auto record(factory_t factory) -> factory_t
+  {
+    return [this, factory = std::move(factory)](uint_t t, int seed) {
+      auto agents = factory(t, seed);
+      if (!agents.empty())
+        created_.emplace_back(t, agents.size());
+      std::vector<any_agent> recorded;
+      recorded.reserve(agents.size());
+      for (auto& agent : agents) {
+        decisions_.emplace_back();
+        recorded.emplace_back(recording_agent{std::move(agent), this, decisions_.size() - 1});
+      }
+      return recorded;
+    };
+  }
+
+  //! Factory that creates agents that replay the recorded decisions.
+  auto replay() const -> factory_t
+  {
+    return [this, next = std::size_t{0}, agent = std::size_t{0}](uint_t t, int) mutable {
+      std::vector<any_agent> agents;
+      if (next < created_.size() && created_[next].first == t) {
+        agents.reserve(created_[next].second);
+        for (std::size_t i = 0; i < created_[next].second; ++i)
+          agents.emplace_back(replaying_agent{this, agent++});
+        ++next;
+      }
+      return agents;
+    };
+  }
+
+  //! Number of recorded agents.
+  auto agents() const -> std::size_t { return decisions_.size(); }
+
+  //! The decisions of an agent, in the order of creation.
+  auto decisions(std::size_t agent) const -> const std::vector<decision_t>& { return decisions_[agent]; }
+
+  //! The regions referred to by the decisions.
+  auto regions() const -> const std::vector<R>& { return regions_; }
+
+  //! Drops every decision.
+  auto clear() -> void
+  {
+    created_.clear();
+    decisions_.clear();
+    regions_.clear();
+    region_index_.clear();
+  }
+
+  //! Writes the log to a binary stream.
+  auto save(std::ostream& os) const -> void requires serializable_region<R>
+  {
+    write_binary(os, regions_.size());
+    for (const auto& region : regions_)
+      region_serializer<R>::write(os, region);
+    write_binary(os, created_.size());
+    for (const auto& [t, count] : created_) {
+      write_binary(os, t);
+      write_binary(os, count);
+    }
+    write_binary(os, decisions_.size());
+    // Field by field, so that the padding of decision_t is not written.
+    for (const auto& decisions : decisions_) {
+      write_binary(os, decisions.size());
+      for (const auto& [kind, region, time, value] : decisions) {
+        write_binary(os, kind);
+        write_binary(os, region);
+        write_binary(os, time);
+        write_binary(os, value);
+      }
+    }
+  }
+
+  //! Restores a log from a binary stream written by \ref save.
+  //!
+  //! \throws std::runtime_error if the stream ends prematurely or holds an invalid decision.
+  auto load(std::istream& is) -> void requires serializable_region<R>
+  {
+    clear();
+    const auto regions = read_binary<std::size_t>(is);
+    for (std::size_t i = 0; i < regions; ++i)
+      intern(region_serializer<R>::read(is));
+    created_.resize(read_binary<std::size_t>(is));
+    for (auto& [t, count] : created_) {
+      t = read_binary<uint_t>(is);
+      count = read_binary<std::size_t>(is);
+    }
+    decisions_.resize(read_binary<std::size_t>(is));
+    for (auto& decisions : decisions_) {
+      decisions.resize(read_binary<std::size_t>(is));
+      for (auto& [kind, region, time, value] : decisions) {
+        kind = read_binary<decision>(is);
+        region = read_binary<std::uint32_t>(is);
+        time = read_binary<uint_t>(is);
+        value = read_binary<value_t>(is);
+        if (kind > decision::keep || (region >= regions_.size() && region != 0)) // Region 0 is also used by phases.
+          throw std::runtime_error{"invalid decision in binary stream"};
+      }
+    }
+  }
+
+private:
+  auto intern(const R& region) -> std::uint32_t
+  {
+    const std::lock_guard lock(mutex_);
+    const auto [it, inserted] = region_index_.try_emplace(region, static_cast<std::uint32_t>(regions_.size()));
+    if (inserted)
+      regions_.push_back(region);
+    return it->second;
+  }
+
+  auto log(std::size_t agent, decision kind, uint_t time, value_t value = 0) -> void
+  {
+    decisions_[agent].push_back({kind, 0, time, value});
+  }
+
+  auto log(std::size_t agent, decision kind, region_view region, uint_t time, value_t value = 0) -> void
+  {
+    decisions_[agent].push_back({kind, intern(region.downcast<R>()), time, value});
+  }
+
+  // Records the calls of the wrapped agent; permits bought and sold are only forwarded.
+  class recording_agent : public agent<R>
+  {
+  public:
+    recording_agent(any_agent agent, decision_log* log, std::size_t id) : agent_(std::move(agent)), log_(log), id_(id) {}
+
+    auto bid_phase(uint_t t, bid_fn bid, permit_public_status_fn status, int seed) -> void override
+    {
+      log_->log(id_, decision::bid_phase, t);
+      auto single = [&](region_view location, uint_t time, value_t value) {
+        log_->log(id_, decision::bid, location, time, value);
+        return bid(location, time, value);
+      };
+      auto bundle = [&](std::span<const bundle_item_t> items) {
+        for (const auto& item : items)
+          log_->log(id_, decision::bundle_item, item.location, item.time, item.value);
+        log_->log(id_, decision::bundle, t);
+        return bid.bundle(items);
+      };
+      auto query = recording_status(status);
+      agent_.bid_phase(t, bid_fn(single, bundle), permit_public_status_fn(query), seed);
+    }
+
+    auto ask_phase(uint_t t, ask_fn ask, permit_public_status_fn status, int seed) -> void override
+    {
+      log_->log(id_, decision::ask_phase, t);
+      auto recording_ask = [&](region_view location, uint_t time, value_t value) {
+        log_->log(id_, decision::ask, location, time, value);
+        return ask(location, time, value);
+      };
+      auto query = recording_status(status);
+      agent_.ask_phase(t, ask_fn(recording_ask), permit_public_status_fn(query), seed);
+    }
+
+    auto on_bought(const R& region, uint_t time, value_t value) -> void override { agent_.on_bought(region, time, value); }
+
+    auto on_sold(const R& region, uint_t time, value_t value) -> void override { agent_.on_sold(region, time, value); }
+
+    auto stop(uint_t t, int seed) -> bool override
+    {
+      const auto result = agent_.stop(t, seed);
+      log_->log(id_, result ? decision::stop : decision::keep, t);
+      return result;
+    }
+
+  private:
+    auto recording_status(permit_public_status_fn status)
+    {
+      return [this, status](region_view location, uint_t time) {
+        log_->log(id_, decision::status, location, time);
+        return status(location, time);
+      };
+    }
+
+    any_agent agent_;
+    decision_log* log_;
+    std::size_t id_;
+  };
+
+  // Repeats the recorded calls of an agent, in order.
+  class replaying_agent : public agent<R>
+  {
+  public:
+    replaying_agent(const decision_log* log, std::size_t id) : log_(log), id_(id) {}
+
+    auto bid_phase(uint_t t, bid_fn bid, permit_public_status_fn status, int) -> void override
+    {
+      if (!enter(decision::bid_phase, t))
+        return;
+      const auto& decisions = log_->decisions_[id_];
+      const auto& regions = log_->regions_;
+      for (; next_ < decisions.size() && !boundary(decisions[next_].kind); ++next_) {
+        const auto& d = decisions[next_];
+        switch (d.kind) {
+        case decision::status:
+          (void)status(regions[d.region], d.time);
+          break;
+        case decision::bid:
+          bid(regions[d.region], d.time, d.value);
+          break;
+        case decision::bundle_item:
+          items_.push_back({regions[d.region], d.time, d.value});
+          break;
+        case decision::bundle:
+          bid.bundle(items_);
+          items_.clear();
+          break;
+        default:
+          assert(false && "unexpected decision in the bid phase");
+        }
+      }
+    }
+
+    auto ask_phase(uint_t t, ask_fn ask, permit_public_status_fn status, int) -> void override
+    {
+      if (!enter(decision::ask_phase, t))
+        return;
+      const auto& decisions = log_->decisions_[id_];
+      const auto& regions = log_->regions_;
+      for (; next_ < decisions.size() && !boundary(decisions[next_].kind); ++next_) {
+        const auto& d = decisions[next_];
+        if (d.kind == decision::status)
+          (void)status(regions[d.region], d.time);
+        else if (d.kind == decision::ask)
+          ask(regions[d.region], d.time, d.value);
+        else
+          assert(false && "unexpected decision in the ask phase");
+      }
+    }
+
+    auto stop(uint_t t, int) -> bool override
+    {
+      const auto& decisions = log_->decisions_[id_];
+      if (next_ < decisions.size() && decisions[next_].time == t &&
+          (decisions[next_].kind == decision::stop || decisions[next_].kind == decision::keep))
+        return decisions[next_++].kind == decision::stop;
+      // The recording ended before the agent stopped.
+      return next_ >= decisions.size();
+    }
+
+  private:
+    static auto boundary(decision kind) -> bool
+    {
+      return kind == decision::bid_phase || kind == decision::ask_phase || kind == decision::stop || kind == decision::keep;
+    }
+
+    // Skips the marker of a phase, if it is the next decision.
+    auto enter(decision phase, uint_t t) -> bool
+    {
+      const auto& decisions = log_->decisions_[id_];
+      if (next_ >= decisions.size() || decisions[next_].kind != phase || decisions[next_].time != t)
+        return false;
+      ++next_;
+      return true;
+    }
+
+    const decision_log* log_;
+    std::size_t id_;
+    std::size_t next_ = 0;
+    std::vector<bundle_item_t> items_;
+  };
+
+  std::vector<std::pair<uint_t, std::size_t>> created_; // Number of agents created at each step with arrivals.
+  std::vector<std::vector<decision_t>> decisions_;
+  std::vector<R> regions_;
+  std::unordered_map<R, std::uint32_t> region_index_;
+  std::mutex mutex_; // Guards regions_ and region_index_ while agents are recorded.
+};
+
+} // namespace uat
+
+#endif // UAT_REPLAY_HPP
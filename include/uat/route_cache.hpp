@@ -0,0 +1,151 @@
+//! \file route_cache.hpp
+//! \brief Defines a cache of planned routes shared by agents.
+
+#ifndef UAT_ROUTE_CACHE_HPP
+#define UAT_ROUTE_CACHE_HPP
+
+#include <uat/planner.hpp>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+namespace uat
+{
+
+//! \brief Cache of routes found by \ref plan_route, shared by agents with common demands.
+//!
+//! Routes are keyed by origin, destination and departure window.  When the cache is given to
+//! the simulation (see `simulation_opts_t::routes`), an entry is dropped as soon as a
+//! permit on its route is traded or put on sale, or its departure time is past.  Every hit is
+//! also checked against the status function of the requesting agent, so a cached route is
+//! only returned if all of its permits are available to (or owned by) that agent.
+//!
+//! All users of a cache must plan with the same neighbors, cost model and heuristic.  Searches
+//! that find no route are not cached.  The cache is not thread-safe.
+template <region_compatible R> class route_cache
+{
+public:
+  //! Returns the cached route for the request, or plans and caches a new one.
+  //!
+  //! The arguments are the same as in \ref plan_route.
+  template <typename Neighbors, typename Cost, typename Heuristic>
+  auto plan(permit_public_status_fn status, const R& from, const R& to, const planner_opts_t& opts, Neighbors&& neighbors,
+            Cost&& cost, Heuristic&& heuristic) -> std::optional<route_plan_t<R>>
+  {
+    const key_t key{from, to, opts.earliest_departure, opts.latest_departure};
+    if (const auto it = entries_.find(key); it != entries_.end()) {
+      const auto usable = [&](const permit<R>& p) {
+        return !std::holds_alternative<permit_public_status::unavailable>(status(p.location, p.time));
+      };
+      if (std::ranges::all_of(it->second.permits, usable)) {
+        ++hits_;
+        return it->second;
+      }
+      erase(key);
+    }
+
+    ++misses_;
+    auto plan = plan_route(status, from, to, opts, neighbors, cost, heuristic);
+    if (plan && !plan->permits.empty()) {
+      for (const auto& p : plan->permits)
+        users_[p].push_back(key);
+      departures_.emplace(plan->permits.front().time, key);
+      entries_.emplace(key, *plan);
+    }
+    return plan;
+  }
+
+  //! Returns the cached route for the request, or plans and caches a new one with the default cost model.
+  template <typename Neighbors, typename Heuristic>
+  auto plan(permit_public_status_fn status, const R& from, const R& to, const planner_opts_t& opts, Neighbors&& neighbors,
+            Heuristic&& heuristic) -> std::optional<route_plan_t<R>>
+  {
+    return plan(status, from, to, opts, neighbors, min_value_cost{}, heuristic);
+  }
+
+  //! Drops the routes that use a permit (called by the simulation when the permit changes state).
+  auto invalidate(const R& region, uint_t time) -> void
+  {
+    const auto it = users_.find({region, time});
+    if (it == users_.end())
+      return;
+    const auto keys = std::move(it->second);
+    for (const auto& key : keys)
+      erase(key);
+  }
+
+  //! Drops the routes departing before the given time (called by the simulation at every step).
+  auto advance(uint_t time) -> void
+  {
+    while (!departures_.empty() && departures_.begin()->first < time) {
+      const auto [departure, key] = *departures_.begin();
+      departures_.erase(departures_.begin());
+      if (const auto it = entries_.find(key); it != entries_.end() && it->second.permits.front().time == departure)
+        erase(key);
+    }
+  }
+
+  //! Drops every route.
+  auto clear() -> void
+  {
+    entries_.clear();
+    users_.clear();
+    departures_.clear();
+  }
+
+  auto size() const -> std::size_t { return entries_.size(); } //!< Number of cached routes.
+  auto hits() const -> uint_t { return hits_; }                //!< Requests answered by the cache.
+  auto misses() const -> uint_t { return misses_; }            //!< Requests that needed a search.
+
+private:
+  struct key_t
+  {
+    R from, to;
+    uint_t earliest, latest;
+
+    auto operator==(const key_t&) const -> bool = default;
+  };
+
+  struct key_hash
+  {
+    auto operator()(const key_t& key) const noexcept -> std::size_t
+    {
+      std::size_t seed = 0;
+      boost::hash_combine(seed, std::hash<R>{}(key.from));
+      boost::hash_combine(seed, std::hash<R>{}(key.to));
+      boost::hash_combine(seed, key.earliest);
+      boost::hash_combine(seed, key.latest);
+      return seed;
+    }
+  };
+
+  auto erase(const key_t& key) -> void
+  {
+    const auto it = entries_.find(key);
+    if (it == entries_.end())
+      return;
+    for (const auto& p : it->second.permits) {
+      const auto users = users_.find(p);
+      if (users == users_.end())
+        continue;
+      std::erase(users->second, key);
+      if (users->second.empty())
+        users_.erase(users);
+    }
+    entries_.erase(it);
+  }
+
+  std::unordered_map<key_t, route_plan_t<R>, key_hash> entries_;
+  std::unordered_map<permit<R>, std::vector<key_t>> users_; // Routes using each permit.
+  std::multimap<uint_t, key_t> departures_;                 // Routes by departure, possibly stale.
+  uint_t hits_ = 0, misses_ = 0;
+};
+
+} // namespace uat
+
+#endif // UAT_ROUTE_CACHE_HPP
@@ -0,0 +1,102 @@
+//! \file scenario.hpp
+//! \brief Synthetic scenarios of drones flying in a three-dimensional grid.
+
+#ifndef UAT_SCENARIO_HPP
+#define UAT_SCENARIO_HPP
+
+#include <uat/simulation.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace uat::scenario
+{
+
+//! A cell of a three-dimensional grid airspace.
+struct cell
+{
+  std::uint32_t x; //!< Longitudinal coordinate.
+  std::uint32_t y; //!< Lateral coordinate.
+  std::uint32_t z; //!< Altitude level.
+
+  auto operator==(const cell& other) const noexcept -> bool = default;
+};
+
+} // namespace uat::scenario
+
+//! \private
+template <> struct std::hash<uat::scenario::cell>
+{
+  auto operator()(const uat::scenario::cell& c) const noexcept -> std::size_t
+  {
+    size_t seed = 0;
+    boost::hash_combine(seed, c.x);
+    boost::hash_combine(seed, c.y);
+    boost::hash_combine(seed, c.z);
+    return seed;
+  }
+};
+
+namespace uat::scenario
+{
+
+//! Options to generate a synthetic scenario.
+struct scenario_opts_t
+{
+  std::uint32_t width = 16; //!< Number of cells along the x axis.
+  std::uint32_t depth = 16; //!< Number of cells along the y axis.
+  std::uint32_t height = 4; //!< Number of altitude levels.
+
+  double arrival_rate = 10.0;                                //!< Mean number of agents arriving per step (Poisson).
+  uint_t arrival_steps = std::numeric_limits<uint_t>::max(); //!< Number of steps in which agents arrive.
+  uint_t min_route_length = 2;                               //!< Minimum number of cells in a route.
+  uint_t max_route_length = 8;                               //!< Maximum number of cells in a route.
+  double valuation_mu = 0.0;                                 //!< Location of the log-normal route valuation.
+  double valuation_sigma = 0.5;                              //!< Scale of the log-normal route valuation.
+  double resale_probability = 0.5;                           //!< Probability that an agent resells partial routes.
+  uint_t patience = 16;                                      //!< Steps an agent keeps trying before giving up.
+  uint_t search_window = 8;                                  //!< Departure times considered in each bid phase.
+  bool bundle_bids = false;                                  //!< Whether agents bid for their routes atomically.
+};
+
+//! \brief Agent that needs every permit along a route, one cell per time step.
+//!
+//! In each bid phase, the agent looks for the earliest departure (within the search window)
+//! at which the whole route is available and bids its valuation split evenly among the cells,
+//! either permit by permit or as a single bundle.  Agents that end up with a partial route
+//! either put those permits back on sale or keep them.
+//! An agent stops once it owns the complete route or its patience is exhausted.
+class route_agent : public agent<cell>
+{
+public:
+  route_agent(std::vector<cell> route, value_t valuation, bool resells, uint_t deadline, uint_t search_window,
+              bool bundles = false);
+
+  auto bid_phase(uint_t time, bid_fn bid, permit_public_status_fn status, int seed) -> void override;
+  auto ask_phase(uint_t time, ask_fn ask, permit_public_status_fn status, int seed) -> void override;
+  auto on_bought(const cell& region, uint_t time, value_t value) -> void override;
+  auto on_sold(const cell& region, uint_t time, value_t value) -> void override;
+  auto stop(uint_t time, int seed) -> bool override;
+
+private:
+  std::vector<cell> route_;
+  value_t valuation_;
+  bool resells_;
+  uint_t deadline_;
+  uint_t search_window_;
+  bool bundles_;
+
+  std::vector<permit<cell>> owned_;
+  bool complete_ = false;
+};
+
+//! Generates a random route of adjacent cells with the given length.
+auto random_route(const scenario_opts_t& opts, uint_t length, std::mt19937& rnd) -> std::vector<cell>;
+
+//! Creates a factory that generates \ref route_agent instances with Poisson arrivals.
+auto make_factory(scenario_opts_t opts) -> factory_t;
+
+} // namespace uat::scenario
+
+#endif // UAT_SCENARIO_HPP
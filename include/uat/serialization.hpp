@@ -0,0 +1,93 @@
+//! \file serialization.hpp
+//! \brief Binary serialization utilities used by simulation checkpoints.
+
+#ifndef UAT_SERIALIZATION_HPP
+#define UAT_SERIALIZATION_HPP
+
+#include <uat/type.hpp>
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace uat
+{
+
+//! Writes the object representation of a trivially copyable value to a binary stream.
+//!
+//! \note The representation is native (endianness and padding of the host), so checkpoints
+//!       are only portable between builds for the same platform.
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+auto write_binary(std::ostream& os, const T& value) -> void
+{
+  os.write(reinterpret_cast<const char*>(std::addressof(value)), sizeof(T));
+}
+
+//! Reads a trivially copyable value previously written with \ref write_binary.
+//!
+//! \throws std::runtime_error if the stream ends prematurely.
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+auto read_binary(std::istream& is) -> T
+{
+  T value;
+  is.read(reinterpret_cast<char*>(std::addressof(value)), sizeof(T));
+  if (!is)
+    throw std::runtime_error{"unexpected end of binary stream"};
+  return value;
+}
+
+//! Writes a length-prefixed string to a binary stream.
+inline auto write_string(std::ostream& os, std::string_view str) -> void
+{
+  write_binary(os, str.size());
+  os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+//! Reads a length-prefixed string previously written with \ref write_string.
+//!
+//! \throws std::runtime_error if the stream ends prematurely.
+inline auto read_string(std::istream& is) -> std::string
+{
+  std::string str(read_binary<std::size_t>(is), '\0');
+  is.read(str.data(), static_cast<std::streamsize>(str.size()));
+  if (!is)
+    throw std::runtime_error{"unexpected end of binary stream"};
+  return str;
+}
+
+//! \brief Customization point to (de)serialize regions in checkpoints.
+//!
+//! The default implementation handles trivially copyable regions by copying their object
+//! representation.  Other region types must specialize this class with the static member
+//! functions `write(std::ostream&, const R&)` and `read(std::istream&) -> R`.
+template <typename R> struct region_serializer
+{
+  //! Writes the region to the stream.
+  static auto write(std::ostream& os, const R& region) -> void requires std::is_trivially_copyable_v<R>
+  {
+    write_binary(os, region);
+  }
+
+  //! Reads a region from the stream.
+  static auto read(std::istream& is) -> R requires std::is_trivially_copyable_v<R> { return read_binary<R>(is); }
+};
+
+//! Concept for region types that can be stored in checkpoints.
+template <typename R>
+concept serializable_region = region_compatible<R> && requires(std::ostream& os, std::istream& is, const R& region)
+{
+  region_serializer<R>::write(os, region);
+  {
+    region_serializer<R>::read(is)
+    } -> std::same_as<R>;
+};
+
+} // namespace uat
+
+#endif // UAT_SERIALIZATION_HPP
@@ -5,10 +5,36 @@
 #define UAT_SIMULATION_HPP
 
 #include <uat/agent.hpp>
+#include <uat/book.hpp>
+#include <uat/market.hpp>
+#include <uat/metrics.hpp>
+#include <uat/route_cache.hpp>
+#include <uat/serialization.hpp>
+#include <uat/thread_pool.hpp>
+#include <uat/trace.hpp>
+#include <uat/trade_log.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <ctime>
 #include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <random>
+#include <span>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <cool/compose.hpp>
@@ -19,6 +45,9 @@ namespace uat
 //! A function type that generates agents for each iteration.
 using factory_t = std::function<std::vector<any_agent>(uint_t, int)>;
 
+//! A function type that restores an agent from the bytes written by `agent::serialize`.
+using agent_deserializer_t = std::function<any_agent(std::istream&)>;
+
 //! Type to represent the information in a trade transaction.
 template <region_compatible R> struct trade_info_t
 {
@@ -30,41 +59,15 @@ template <region_compatible R> struct trade_info_t
   value_t value;
 };
 
-//! Unique value to represent the absence of an owner.
-constexpr auto no_owner = std::numeric_limits<uint_t>::max();
-
-namespace permit_private_status
-{
-
-//! Represents the private status of a permit that is available for trading.
-struct on_sale
-{
-  uint_t owner = no_owner;          //!< The owner of the permit.
-  value_t min_value = 0.0;          //!< The minimum value (exclusive) that the owner is willing to sell the permit.
-  uint_t highest_bidder = no_owner; //!< The current highest bidder.
-  value_t highest_bid = 0.0;        //!< The current highest bid.
-};
-
-//! Represents the private status of a permit that is not available for trading.
-struct in_use
-{
-  uint_t owner;
-};
-
-//! Represents the private status of a permit that is out of limits (past and future).
-struct out_of_limits
-{};
-
-} // namespace permit_private_status
-
-//! Represents the private status of a permit.
-struct permit_private_status_t
+//! \brief Changes of the simulation state in a step.
+//!
+//! The spans are only valid during the delta callback.
+template <region_compatible R> struct step_changes_t
 {
-  //! The current status of the permit.
-  std::variant<permit_private_status::on_sale, permit_private_status::in_use, permit_private_status::out_of_limits> current;
-
-  //! The history of trades involving the permit.
-  std::vector<trade_value_t> history;
+  uint_t time;                                 //!< The time step in which the changes happened.
+  std::span<const permit_change_t<R>> permits; //!< Permits that changed, in the order of the changes.
+  std::span<const id_t> agents_added;          //!< Agents generated by the factory.
+  std::span<const id_t> agents_stopped;        //!< Agents removed from the simulation.
 };
 
 namespace agent_private_status
@@ -92,28 +95,252 @@ using agent_private_status_t = std::variant<agent_private_status::inactive, agen
 class agents_private_status_t
 {
 public:
+  //! Creates an empty collection whose containers allocate from the given memory resource.
+  explicit agents_private_status_t(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
   auto status(id_t) const -> agent_private_status_t; //!< Get the private status of an agent with the given id.
   auto active_count() const -> uint_t;               //!< Get the number of active agents.
   auto active() const -> std::span<const id_t>;      //!< Get the ids of the active agents.
 
-  void insert(any_agent);                //!< \private
-  void update_active(std::vector<id_t>); //!< \private
-  auto at(id_t) -> any_agent&;           //!< \private
+  void insert(any_agent);                           //!< \private
+  void reserve(uint_t);                             //!< \private
+  void remove_active(std::span<const std::size_t>); //!< \private
+  auto at(id_t) -> any_agent&;                      //!< \private
+
+  void serialize(std::ostream&) const;                          //!< \private
+  void deserialize(std::istream&, const agent_deserializer_t&); //!< \private
 
 private:
   uint_t first_id_ = 0u;
-  std::deque<any_agent> agents_;
-  std::vector<id_t> active_;
+  std::pmr::deque<any_agent> agents_;
+  std::pmr::vector<id_t> active_;
 };
 
 //! Function reference that allows the simulation to access the private status of an agent.
 using permit_private_status_fn = type_safe::function_ref<permit_private_status_t(region_view, uint_t)>;
 
+//! \brief Read-only view of the book given to simulation callbacks.
+//!
+//! Calling the view returns the private status of a permit, like \ref permit_private_status_fn
+//! (to which it converts).  Additionally, `for_each` visits the permits stored in the book in a
+//! single pass, bucket by bucket in increasing time, without copying them.  The visitor receives
+//! the region (to be downcast to the region type of the simulation), the time and the status of
+//! each permit.  Permits not stored in the book are on sale by nobody, with no history.
+//!
+//! The view and the statuses it visits are only valid during the callback.
+class book_view
+{
+public:
+  //! Function reference that receives the permits visited by \ref for_each.
+  using visitor_fn = type_safe::function_ref<void(region_view, uint_t, const permit_private_status_t&)>;
+
+  //! \private
+  template <typename Lookup, typename Visit> book_view(Lookup& lookup, Visit& visit) : lookup_(lookup), visit_(visit) {}
+
+  //! Private status of a permit (never creates entries in the book).
+  auto operator()(region_view location, uint_t time) const -> permit_private_status_t { return lookup_(location, time); }
+
+  //! Point lookups alone, as received by simulation callbacks before the view existed.
+  operator permit_private_status_fn() const noexcept { return lookup_; }
+
+  //! Visits every permit stored in the book.
+  template <std::invocable<region_view, uint_t, const permit_private_status_t&> F> auto for_each(F&& visitor) const -> void
+  {
+    for_each(0, std::numeric_limits<uint_t>::max(), visitor);
+  }
+
+  //! Visits the permits stored in the book with times in `[t_begin, t_end)`.
+  template <std::invocable<region_view, uint_t, const permit_private_status_t&> F>
+  auto for_each(uint_t t_begin, uint_t t_end, F&& visitor) const -> void
+  {
+    visit_(t_begin, t_end, visitor_fn(visitor));
+  }
+
+private:
+  permit_private_status_fn lookup_;
+  type_safe::function_ref<void(uint_t, uint_t, visitor_fn)> visit_;
+};
+
 //! Callback type that receives information about a trade transaction.
 template <region_compatible R> using trade_callback_t = std::function<void(trade_info_t<R>)>;
 
-//! Callback type that receives information about the status of the simulation.
-using simulation_callback_t = std::function<void(uint_t, const agents_private_status_t&, permit_private_status_fn)>;
+//! \brief Callback type that receives the changes of each step.
+//!
+//! Called at the end of every step, so that consumers can update their views in time
+//! proportional to the number of changes.
+template <region_compatible R> using delta_callback_t = std::function<void(const step_changes_t<R>&)>;
+
+//! \brief Callback type that receives information about the status of the simulation.
+//!
+//! The third argument gives access to the permits in the book, and the last one holds the
+//! metrics of the previous step (see \ref metrics_enabled).  Functions without the metrics
+//! argument are also accepted, including those taking a \ref permit_private_status_fn, to
+//! which the book view converts; the metrics remain available from `simulation::metrics()`.
+class simulation_callback_t
+{
+public:
+  //! Type of the function that receives every argument.
+  using function_type = std::function<void(uint_t, const agents_private_status_t&, book_view, const simulation_metrics_t&)>;
+
+  //! Creates an empty callback.
+  simulation_callback_t() = default;
+
+  //! Creates a callback that receives the metrics.
+  template <typename F>
+  requires std::invocable<F&, uint_t, const agents_private_status_t&, book_view, const simulation_metrics_t&>
+  simulation_callback_t(F f) : f_(std::move(f))
+  {}
+
+  //! Creates a callback that ignores the metrics.
+  template <typename F>
+  requires(!std::invocable<F&, uint_t, const agents_private_status_t&, book_view, const simulation_metrics_t&> &&
+           std::invocable<F&, uint_t, const agents_private_status_t&, book_view&>)
+  simulation_callback_t(F f)
+    : f_([f = std::move(f)](uint_t t, const agents_private_status_t& agents, book_view book, const simulation_metrics_t&) //
+         mutable { f(t, agents, book); })
+  {}
+
+  //! Whether the callback holds a function.
+  explicit operator bool() const noexcept { return static_cast<bool>(f_); }
+
+  //! Calls the function.
+  auto operator()(uint_t t, const agents_private_status_t& agents, book_view book, const simulation_metrics_t& metrics) const
+    -> void
+  {
+    f_(t, agents, book, metrics);
+  }
+
+private:
+  function_type f_;
+};
+
+//! \private
+//! Trades and changes of a step, copied out of the engine for the reporting thread.
+template <region_compatible R> struct step_report_t
+{
+  uint_t time = 0;
+  std::vector<trade_info_t<R>> trades;
+  std::vector<permit_change_t<R>> permits;
+  std::vector<id_t> agents_added, agents_stopped;
+
+  auto clear() -> void
+  {
+    trades.clear();
+    permits.clear();
+    agents_added.clear();
+    agents_stopped.clear();
+  }
+};
+
+//! \private
+//! Delivers step reports to the trade and delta callbacks on a dedicated thread.
+//!
+//! At most `depth` reports are queued; \ref submit blocks while the queue is full.  The reports
+//! live in a ring and are swapped with the producer's buffer, so that their capacity is reused.
+template <region_compatible R> class report_pipeline
+{
+public:
+  report_pipeline(std::size_t depth, trade_callback_t<R> trade_callback, delta_callback_t<R> delta_callback, tracer* trace)
+    : slots_(depth), trade_callback_(std::move(trade_callback)), delta_callback_(std::move(delta_callback)), trace_(trace)
+  {
+    worker_ = std::thread([this] { work(); });
+  }
+
+  report_pipeline(const report_pipeline&) = delete;
+  auto operator=(const report_pipeline&) -> report_pipeline& = delete;
+
+  // Delivers the queued reports before joining; errors not yet rethrown are lost.
+  ~report_pipeline()
+  {
+    {
+      std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    ready_.notify_one();
+    worker_.join();
+  }
+
+  // Queues the report and hands back a cleared buffer.  Errors are left for rethrow_pending.
+  auto submit(step_report_t<R>& report) -> void
+  {
+    std::unique_lock lock{mutex_};
+    free_.wait(lock, [&] { return count_ < slots_.size(); });
+    std::swap(report, slots_[(head_ + count_) % slots_.size()]);
+    ++count_;
+    lock.unlock();
+    ready_.notify_one();
+    report.clear();
+  }
+
+  // Rethrows the first error of a callback, if any, without waiting.
+  auto rethrow_pending() -> void
+  {
+    std::unique_lock lock{mutex_};
+    rethrow(lock);
+  }
+
+  // Blocks until every queued report is delivered.  Rethrows the first error of a callback.
+  auto flush() -> void
+  {
+    std::unique_lock lock{mutex_};
+    free_.wait(lock, [&] { return count_ == 0 || error_; });
+    rethrow(lock);
+  }
+
+private:
+  auto rethrow(std::unique_lock<std::mutex>& lock) -> void
+  {
+    if (!error_)
+      return;
+    auto error = std::exchange(error_, nullptr);
+    lock.unlock();
+    std::rethrow_exception(error);
+  }
+
+  auto work() -> void
+  {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      ready_.wait(lock, [&] { return count_ > 0 || stopping_; });
+      if (count_ == 0)
+        return;
+
+      // The producer never touches a queued slot, so it is read without the lock.
+      const auto& report = slots_[head_];
+      lock.unlock();
+      try {
+        trace_scope scope(trace_, "report", report.time);
+        if (trade_callback_)
+          for (const auto& trade : report.trades)
+            trade_callback_(trade);
+        if (delta_callback_)
+          delta_callback_(step_changes_t<R>{report.time, report.permits, report.agents_added, report.agents_stopped});
+      } catch (...) {
+        std::lock_guard error_lock{mutex_};
+        if (!error_)
+          error_ = std::current_exception();
+      }
+      lock.lock();
+      head_ = (head_ + 1) % slots_.size();
+      --count_;
+      free_.notify_one();
+    }
+  }
+
+  std::vector<step_report_t<R>> slots_;
+  std::size_t head_ = 0, count_ = 0;
+  trade_callback_t<R> trade_callback_;
+  delta_callback_t<R> delta_callback_;
+  tracer* trace_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_, free_;
+  bool stopping_ = false;
+  std::exception_ptr error_;
+  std::thread worker_;
+};
+
+struct stop_criterion_t;
 
 namespace stop_criterion
 {
@@ -127,178 +354,928 @@ struct time_threshold_t
 {
   uint_t t;
 };
+
+//! Stop criterion that stops the simulation after a number of consecutive steps without trades.
+struct no_trades_t
+{
+  uint_t steps;
+};
+
+//! Stop criterion that stops the simulation when few permits were traded in the last steps.
+struct trade_volume_below_t
+{
+  uint_t window;    //!< Number of steps in the sliding window.
+  uint_t threshold; //!< The simulation stops if fewer trades than this occurred in the window.
+};
+
+//! Stop criterion that stops the simulation once a wall-clock budget is exhausted.
+struct wall_clock_budget_t
+{
+  std::chrono::nanoseconds budget;
+};
+
+//! Stop criterion that stops the simulation once a (process) CPU time budget is exhausted.
+struct cpu_budget_t
+{
+  std::chrono::nanoseconds budget;
+};
+
+//! Stop criterion satisfied when any of its criteria is satisfied.
+struct any_of_t
+{
+  std::vector<stop_criterion_t> criteria;
+};
+
+//! Stop criterion satisfied when all of its criteria are satisfied.
+struct all_of_t
+{
+  std::vector<stop_criterion_t> criteria;
+};
+
 } // namespace stop_criterion
 
 //! Variant that represents the possible stop criteria for the simulation.
-using stop_criterion_t = std::variant<stop_criterion::no_agents_t, stop_criterion::time_threshold_t>;
+struct stop_criterion_t
+  : std::variant<stop_criterion::no_agents_t, stop_criterion::time_threshold_t, stop_criterion::no_trades_t,
+                 stop_criterion::trade_volume_below_t, stop_criterion::wall_clock_budget_t, stop_criterion::cpu_budget_t,
+                 stop_criterion::any_of_t, stop_criterion::all_of_t>
+{
+  using variant::variant;
+};
+
+//! Creates a criterion satisfied when any of the given criteria is satisfied.
+template <typename... Criteria> auto any_of(Criteria... criteria) -> stop_criterion_t
+{
+  return stop_criterion::any_of_t{{stop_criterion_t{std::move(criteria)}...}};
+}
+
+//! Creates a criterion satisfied when all of the given criteria are satisfied.
+template <typename... Criteria> auto all_of(Criteria... criteria) -> stop_criterion_t
+{
+  return stop_criterion::all_of_t{{stop_criterion_t{std::move(criteria)}...}};
+}
+
+//! \private
+//! Incremental evaluation of a stop criterion: every step costs O(1) per criterion.
+class stop_condition_t
+{
+public:
+  explicit stop_condition_t(const stop_criterion_t&);
+
+  auto record_step(uint_t trades) -> void;
+  auto satisfied(uint_t time, uint_t active_agents) const -> bool;
+
+  auto serialize(std::ostream&) const -> void;
+  auto deserialize(std::istream&) -> void;
+
+private:
+  stop_criterion_t criterion_;
+  std::vector<stop_condition_t> children_;
+
+  uint_t quiet_steps_ = 0;
+  std::vector<uint_t> window_;
+  uint_t window_pos_ = 0;
+  uint_t window_sum_ = 0;
+  uint_t recorded_steps_ = 0;
+
+  std::chrono::steady_clock::time_point wall_start_;
+  std::clock_t cpu_start_;
+};
+
+//! Options to periodically save the state of the simulation.
+struct checkpoint_opts_t
+{
+  std::filesystem::path path; //!< File that is (atomically) replaced by each new checkpoint.
+  uint_t every = 1;           //!< Number of time steps between two consecutive checkpoints.
+};
+
+//! \brief Memory resources and capacities of the containers of the simulation engine.
+//!
+//! Null resources stand for `std::pmr::get_default_resource()` at the time the simulation is
+//! created.  The resources must outlive the simulation.
+//!
+//! Per-step buffers and the time buckets of the book are cleared and reused from one step to
+//! the next, so they stop growing once they reach their peak size.  Book entries and trade
+//! histories, however, are created and destroyed at every step.  To run without any heap
+//! allocation after a warm-up, use pool resources (e.g., `std::pmr::unsynchronized_pool_resource`)
+//! for the book and the per-step buffers, declare the capacities below, and use a factory
+//! and agents that do not allocate in the steady state.
+struct memory_opts_t
+{
+  std::pmr::memory_resource* book = nullptr;      //!< Time buckets, book entries and their trade histories.
+  std::pmr::memory_resource* agents = nullptr;    //!< Storage of the agents and of the active set.
+  std::pmr::memory_resource* transient = nullptr; //!< Per-step buffers of bids, asks and bundles.
+
+  uint_t agents_capacity = 0;  //!< Active agents reserved up front.
+  uint_t bids_capacity = 0;    //!< Permits with bids in a single step reserved up front.
+  uint_t asks_capacity = 0;    //!< Asks in a single step reserved up front.
+  uint_t bundles_capacity = 0; //!< Bundles in a single step reserved up front.
+};
 
 //! Options to configure the simulation.
 template <region_compatible R> struct simulation_opts_t
 {
-  factory_t factory;                         //!< Generator of agents for each iteration.
-  std::optional<uint_t> time_window;         //!< Maximum time ahead a permit can be traded.
-  stop_criterion_t stop_criterion;           //!< The criterion to stop the simulation.
-  trade_callback_t<R> trade_callback;        //!< Callback to receive information about a trade transaction.
-  simulation_callback_t simulation_callback; //!< Callback to receive information about the status of the simulation.
-  std::optional<uint_t> seed;                //!< Random seed.
+  factory_t factory;                                //!< Generator of agents for each iteration.
+  std::optional<uint_t> time_window;                //!< Maximum time ahead a permit can be traded.
+  stop_criterion_t stop_criterion;                  //!< The criterion to stop the simulation.
+  trade_callback_t<R> trade_callback;               //!< Callback to receive information about a trade transaction.
+  simulation_callback_t simulation_callback;        //!< Callback to receive information about the status of the simulation.
+  std::optional<uint_t> seed;                       //!< Random seed.
+  std::optional<checkpoint_opts_t> checkpoint;      //!< Periodic checkpointing of the simulation state.
+  std::optional<std::filesystem::path> resume_from; //!< Checkpoint file to resume the simulation from.
+  agent_deserializer_t agent_deserializer;          //!< Restores agents when resuming from a checkpoint.
+  tracer* trace = nullptr;                          //!< Tracer that records the phases of each step (optional).
+  route_cache<R>* routes = nullptr;                 //!< Cache of routes kept up to date with the book (optional).
+  memory_opts_t memory = {};                        //!< Memory resources of the engine containers.
+  delta_callback_t<R> delta_callback;               //!< Callback to receive the changes of each step.
+  uint_t market_window = 16;                        //!< Steps in the window of the region market statistics (0 disables them).
+  trade_log_writer<R>* trade_log = nullptr;         //!< Log of the changes of the book, for replay (optional).
+  thread_pool* pool = nullptr;                      //!< Pool that runs agent callbacks in parallel (optional).
+  uint_t report_depth = 0;                          //!< Steps that may await the reporting thread (0 runs callbacks inline).
 };
 
-//! A simulation of a first-price sealed-bid auction.
+//! \private
+constexpr std::uint64_t checkpoint_magic = 0x0354504b43544155; // "UATCKPT" followed by the format version.
+
+//! \brief A first-price sealed-bid auction that can be advanced step by step.
 //!
-//! \param factory A function that generates agents for each iteration.
-//! \param seed A random seed.
-//! \param opts Options to configure the simulation.
-template <region_compatible R> auto simulate(const simulation_opts_t<R>& opts = {}) -> void
+//! All the state of the auction (book, agents, random engine and current time) is owned by
+//! this object and kept allocated across steps, so a simulation can be embedded in a larger
+//! co-simulation, driven by an external scheduler or inspected between steps.
+//!
+//! With `simulation_opts_t::pool`, the ask phase, the delivery of trades (`on_bought` and
+//! `on_sold`) and the stop criterion of the agents run in parallel.  Each agent receives its
+//! trades in the same order as in a sequential run, and the outcome is identical, but agents
+//! must not share mutable state (including a \ref route_cache) in these phases, and the
+//! simulation must not run on a worker of the pool.
+//!
+//! With a nonzero `simulation_opts_t::report_depth`, the trade and delta callbacks run on a
+//! reporting thread, which receives copies of the trades and changes of each step while the
+//! next steps proceed.  At most `report_depth` steps await delivery; beyond that, \ref step
+//! blocks.  The callbacks see the steps in order, but concurrently with the simulation and
+//! its other callbacks.  An exception thrown by them is rethrown at the beginning of a later
+//! \ref step, before it changes the simulation, or by \ref flush, which \ref run and
+//! \ref run_until call before returning.
+template <region_compatible R> class simulation
 {
-  std::mt19937 rnd(opts.seed ? *opts.seed : std::random_device{}());
+public:
+  //! Creates a simulation at time zero with the given options.
+  //!
+  //! If `opts.resume_from` is set, the state is restored from that checkpoint instead.
+  explicit simulation(simulation_opts_t<R> opts = {})
+    : opts_(std::move(opts)), rnd_(opts_.seed ? *opts_.seed : std::random_device{}()), stop_(opts_.stop_criterion)
+  {
+    agents_.reserve(opts_.memory.agents_capacity);
+    stopped_positions_.reserve(opts_.memory.agents_capacity);
+    bids_.reserve(opts_.memory.bids_capacity);
+    asks_.reserve(opts_.memory.asks_capacity);
+    bundles_.reserve(opts_.memory.bundles_capacity);
 
-  agents_private_status_t agents;
-  std::vector<id_t> keep_active;
+    if (opts_.report_depth > 0 && (opts_.trade_callback || opts_.delta_callback))
+      reporter_ =
+        std::make_unique<report_pipeline<R>>(opts_.report_depth, opts_.trade_callback, opts_.delta_callback, opts_.trace);
 
-  uint_t t0 = 0;
+    if (opts_.checkpoint || opts_.resume_from || opts_.trade_log) {
+      if constexpr (serializable_region<R>) {
+        if (opts_.resume_from) {
+          std::ifstream is(*opts_.resume_from, std::ios::binary);
+          if (!is)
+            throw std::runtime_error{"could not open checkpoint file"};
+          load(is);
+        }
+      } else {
+        throw std::invalid_argument{"region type does not support serialization"};
+      }
+    }
+  }
 
-  std::deque<std::unordered_map<permit<R>, permit_private_status_t>> data;
+  simulation(const simulation&) = delete;
+  simulation(simulation&&) noexcept = default;
 
-  permit_private_status_t ool = {permit_private_status::out_of_limits{}, {}};
-  auto book = [&t0, &data, &ool, &opts](region_view loc, uint_t t) mutable -> permit_private_status_t& {
-    if (t < t0) // XXX agents can check the state at t0, however they should be prohibited to bid for.
-      return ool;
-    if (opts.time_window && t > t0 + 1 + *opts.time_window)
-      return ool;
-    while (t - t0 >= data.size())
-      data.emplace_back();
-    return data[t - t0][{loc.downcast<R>(), t}];
-  };
+  auto operator=(const simulation&) -> simulation& = delete;
+  auto operator=(simulation&&) noexcept -> simulation& = default;
 
-  auto safe_book = [&book](region_view loc, uint_t t) -> permit_private_status_t { return book(loc, t); };
+  ~simulation()
+  {
+    // The next simulation on this thread needs about as many buckets as this one.
+    const auto depth = data_.size() + spare_.size();
+    for (auto& bucket : data_)
+      release_bucket<R>(std::move(bucket));
+    for (auto& bucket : spare_)
+      release_bucket<R>(std::move(bucket));
+    if (depth > 0)
+      trim_recycled_buckets<R>(depth);
+  }
 
-  auto public_access = [&book](auto id) {
-    return [id = id, &book](region_view s, uint_t t) -> permit_public_status_t {
-      using namespace permit_private_status;
-      using namespace permit_public_status;
-      const auto& pstatus = book(s, t);
-      return std::visit(
-        cool::compose{
-          [](out_of_limits) -> permit_public_status_t { return unavailable{}; },
-          [&](in_use status) -> permit_public_status_t {
-            return status.owner == id ? permit_public_status_t{owned{}} : unavailable{};
-          },
-          [&](on_sale status) -> permit_public_status_t {
-            return status.owner == id ? permit_public_status_t{unavailable{}} : available{status.min_value, pstatus.history};
-          }},
-        pstatus.current);
-    };
-  };
+  //! Advances the simulation by one time step.
+  //!
+  //! A step consists of: generating new agents, the bid phase, trading, the ask phase and
+  //! removing the agents that stop.  The simulation callback is called at its beginning.
+  auto step() -> void
+  {
+    // Errors of the reporting thread surface before the step changes anything.
+    if (reporter_)
+      reporter_->rethrow_pending();
 
-  const auto stop = [&] {
-    using namespace stop_criterion;
-    return std::visit(cool::compose{
-                        [&](no_agents_t) { return agents.active_count() == 0; },
-                        [&](time_threshold_t th) { return t0 > th.t; },
-                      },
-                      opts.stop_criterion);
-  };
+    trace_scope step_scope(opts_.trace, "step", t0_);
+    auto* const agent_trace = opts_.trace && opts_.trace->agent_events() ? opts_.trace : nullptr;
 
-  do {
-    if (opts.simulation_callback)
-      opts.simulation_callback(t0, std::as_const(agents), permit_private_status_fn(safe_book));
+    if (opts_.simulation_callback) {
+      trace_scope scope(opts_.trace, "simulation_callback", t0_);
+      auto safe_book = [this](region_view loc, uint_t t) -> permit_private_status_t { return status(loc, t); };
+      auto visit = [this](uint_t t_begin, uint_t t_end, book_view::visitor_fn visitor) {
+        const auto last = std::min<uint_t>(t_end, t0_ + data_.size());
+        for (auto t = std::max(t_begin, t0_); t < last; ++t)
+          data_[t - t0_].for_each([&](const R& region, const permit_private_status_t& status) { visitor(region, t, status); });
+      };
+      opts_.simulation_callback(t0_, std::as_const(agents_), book_view(safe_book, visit), std::as_const(metrics_));
+    }
+
+    if constexpr (serializable_region<R>) {
+      if (opts_.trade_log && opts_.trade_log->wants_keyframe(t0_)) {
+        trace_scope scope(opts_.trace, "trade_log", t0_);
+        opts_.trade_log->write_keyframe(t0_, [this](auto&& f) {
+          for (uint_t i = 0; i < data_.size(); ++i)
+            data_[i].for_each([&](const R& region, const permit_private_status_t& status) { f(region, t0_ + i, status); });
+        });
+      }
+    }
+
+    metrics_ = {};
 
     // Generate new agents
-    if (opts.factory) {
-      auto new_agents = opts.factory(t0, rnd());
-      for (auto& agent : new_agents)
-        agents.insert(std::move(agent));
+    if (opts_.factory) {
+      trace_scope scope(opts_.trace, "factory", t0_);
+      scoped_timer timer(metrics_.factory_time);
+      auto new_agents = opts_.factory(t0_, rnd_());
+      count_metric(metrics_.agents_created, new_agents.size());
+      for (auto& agent : new_agents) {
+        agents_.insert(std::move(agent));
+        if (recording_changes())
+          added_.push_back(agents_.active().back());
+      }
     }
 
+    // Bid phase
     {
-      // Bid phase
-      std::vector<permit<R>> bids;
-      for (const auto id : agents.active()) {
+      trace_scope scope(opts_.trace, "bid", t0_);
+      scoped_timer timer(metrics_.bid_time);
+      bids_.clear();
+      bundles_.clear();
+      bundle_items_.clear();
+      for (const auto id : agents_.active()) {
         auto bid = [&](region_view s, uint_t t, value_t v) -> bool {
-          if (t < t0)
-            return false;
+          bool accepted = false;
           using namespace permit_private_status;
           const auto visitor = cool::compose{[](out_of_limits) { return false; }, [](in_use) { return false; },
                                              [&](on_sale& status) {
                                                if (v > status.min_value && v > status.highest_bid) {
                                                  if (status.highest_bidder == no_owner)
-                                                   bids.emplace_back(s.downcast<R>(), t);
+                                                   bids_.emplace_back(s.downcast<R>(), t);
                                                  status.highest_bidder = id;
                                                  status.highest_bid = v;
+                                                 accepted = true;
                                                }
                                                return true;
                                              }};
-          return std::visit(visitor, book(s, t).current);
+          const auto result = t >= t0_ && std::visit(visitor, book(s, t).current);
+          count_metric(accepted ? metrics_.bids_accepted : metrics_.bids_rejected);
+          return result;
         };
 
-        auto access = public_access(id);
-        agents.at(id).bid_phase(t0, bid_fn(bid), permit_public_status_fn(access), rnd());
+        // Bundles are only validated here; they compete with each other before trading.
+        auto bundle = [&](std::span<const bundle_item_t> items) -> bool {
+          const auto valid = [&](const bundle_item_t& item) {
+            if (item.time < t0_)
+              return false;
+            const auto* status = std::get_if<permit_private_status::on_sale>(&book(item.location, item.time).current);
+            return status && item.value > status->min_value;
+          };
+          const auto result = !items.empty() && std::ranges::all_of(items, valid);
+          count_metric(result ? metrics_.bundles_accepted : metrics_.bundles_rejected);
+          if (!result)
+            return false;
+
+          value_t total = 0;
+          for (const auto& item : items) {
+            bundle_items_.emplace_back(item.location.template downcast<R>(), item.time, item.value);
+            total += item.value;
+          }
+          bundles_.push_back({id, total, bundle_items_.size() - items.size(), items.size()});
+          return true;
+        };
+
+        auto access = public_access(id, metrics_.book_lookups);
+        trace_scope agent_scope(agent_trace, "bid_phase", t0_, id);
+        agents_.at(id).bid_phase(t0_, bid_fn(bid, bundle), permit_public_status_fn(access), rnd_());
       }
+    }
 
-      // Trading
-      if (bids.size() > 0) {
-        const auto first_active = agents.active().front();
-        for (const auto& [s, t] : bids) {
+    // Trading
+    {
+      trace_scope scope(opts_.trace, "trading", t0_);
+      scoped_timer timer(metrics_.trading_time);
+      if (!bundles_.empty())
+        award_bundles();
+      count_metric(metrics_.trades, bids_.size());
+      stop_.record_step(bids_.size());
+      if (bids_.size() > 0) {
+        const auto first_active = agents_.active().front();
+        const auto deferred = opts_.pool && bids_.size() > 1;
+        settlements_.clear();
+        for (std::size_t i = 0; i < bids_.size(); ++i) {
+          const auto& [s, t] = bids_[i];
           const auto status = std::get<permit_private_status::on_sale>(book(s, t).current);
-          if (opts.trade_callback)
-            opts.trade_callback({t0, status.owner, status.highest_bidder, s, t, status.highest_bid});
+          if (reporter_)
+            report_.trades.push_back({t0_, status.owner, status.highest_bidder, s, t, status.highest_bid});
+          else if (opts_.trade_callback)
+            opts_.trade_callback({t0_, status.owner, status.highest_bidder, s, t, status.highest_bid});
 
-          agents.at(status.highest_bidder).on_bought(s, t, status.highest_bid);
-          if (status.owner != no_owner && status.owner >= first_active)
-            agents.at(status.owner).on_sold(s, t, status.highest_bid);
+          const auto sold = status.owner != no_owner && status.owner >= first_active;
+          if (deferred) {
+            settlements_.push_back({status.highest_bidder, settlements_.size(), i, status.highest_bid, false});
+            if (sold)
+              settlements_.push_back({status.owner, settlements_.size(), i, status.highest_bid, true});
+          } else {
+            agents_.at(status.highest_bidder).on_bought(s, t, status.highest_bid);
+            if (sold)
+              agents_.at(status.owner).on_sold(s, t, status.highest_bid);
+          }
 
           auto& pstatus = book(s, t);
           pstatus.current = permit_private_status::in_use{status.highest_bidder};
           pstatus.history.push_back({status.min_value, status.highest_bid});
+          pstatus.market.add(status.highest_bid);
+          market_.record(s, t0_, status.highest_bid);
+          if (opts_.routes)
+            opts_.routes->invalidate(s, t);
+          if (recording_changes())
+            changes_.push_back({permit_change::traded, s, t});
         }
+        if (deferred)
+          parallel_settlement();
       }
     }
 
     // Ask phase
     {
-      std::vector<std::tuple<R, uint_t, uint_t, value_t>> asks;
-      for (const auto id : agents.active()) {
-        auto ask = [&](region_view s, uint_t t, value_t v) -> bool {
-          if (t < t0)
-            return false;
-          using namespace permit_private_status;
-          const auto visitor = cool::compose{[](out_of_limits) { return false; },
-                                             [&](on_sale status) {
-                                               if (status.owner != id)
-                                                 return false;
-                                               asks.emplace_back(s.downcast<R>(), t, id, v);
-                                               return true;
-                                             },
-                                             [&](in_use& status) {
-                                               if (status.owner != id)
-                                                 return false;
-                                               asks.emplace_back(s.downcast<R>(), t, id, v);
-                                               return true;
-                                             }};
-          return std::visit(visitor, book(s, t).current);
-        };
-
-        auto access = public_access(id);
-        agents.at(id).ask_phase(t0, ask_fn(ask), permit_public_status_fn(access), rnd());
+      trace_scope scope(opts_.trace, "ask", t0_);
+      scoped_timer timer(metrics_.ask_time);
+      asks_.clear();
+      if (opts_.pool && agents_.active_count() > 1) {
+        parallel_ask_phase(agent_trace);
+      } else {
+        ask_counters_t counters;
+        for (const auto id : agents_.active())
+          agent_ask_phase(id, rnd_(), asks_, counters, agent_trace);
+        count_ask_metrics(counters);
       }
 
-      for (const auto& [s, t, id, v] : asks)
+      for (const auto& [s, t, id, v] : asks_) {
         book(s, t).current = permit_private_status::on_sale{.owner = id, .min_value = v};
+        if (opts_.routes)
+          opts_.routes->invalidate(s, t);
+        if (recording_changes())
+          changes_.push_back({permit_change::on_sale, s, t});
+      }
     }
 
     // Stop condition
-    keep_active.clear();
-    keep_active.reserve(agents.active_count());
-    for (const auto id : agents.active())
-      if (!agents.at(id).stop(t0, rnd()))
-        keep_active.push_back(id);
-    agents.update_active(std::move(keep_active));
-
-    if (data.size() > 0)
-      data.pop_front();
-    ++t0;
-  } while (!stop());
-}
+    {
+      trace_scope scope(opts_.trace, "stop", t0_);
+      scoped_timer timer(metrics_.stop_time);
+      const auto active = agents_.active();
+      stopped_positions_.clear();
+      if (opts_.pool && active.size() > 1) {
+        parallel_stop_phase();
+      } else {
+        for (std::size_t i = 0; i < active.size(); ++i)
+          if (agents_.at(active[i]).stop(t0_, rnd_()))
+            stopped_positions_.push_back(i);
+      }
+      if (recording_changes())
+        for (const auto i : stopped_positions_)
+          stopped_.push_back(active[i]);
+      count_metric(metrics_.agents_stopped, stopped_positions_.size());
+      agents_.remove_active(stopped_positions_);
+      count_metric(metrics_.agents_active, agents_.active_count());
+    }
+
+    if constexpr (metrics_enabled) {
+      metrics_.book_buckets = data_.size();
+      for (const auto& bucket : data_) {
+        metrics_.book_entries += bucket.size();
+        metrics_.max_bucket_size = std::max(metrics_.max_bucket_size, bucket.size());
+      }
+    }
+
+    if (data_.size() > 0) {
+      if (recording_changes())
+        data_.front().for_each(
+          [&](const R& region, const permit_private_status_t&) { changes_.push_back({permit_change::expired, region, t0_}); });
+      drop_bucket(std::move(data_.front()));
+      data_.pop_front();
+    }
+
+    if (reporter_) {
+      trace_scope scope(opts_.trace, "report_handoff", t0_);
+      report_.time = t0_;
+      if (opts_.delta_callback) {
+        report_.permits.assign(changes_.begin(), changes_.end());
+        report_.agents_added.assign(added_.begin(), added_.end());
+        report_.agents_stopped.assign(stopped_.begin(), stopped_.end());
+      }
+      reporter_->submit(report_);
+    } else if (opts_.delta_callback) {
+      trace_scope scope(opts_.trace, "delta_callback", t0_);
+      opts_.delta_callback(step_changes_t<R>{t0_, changes_, added_, stopped_});
+    }
+    ++t0_;
+    market_.advance(t0_);
+    if (opts_.routes)
+      opts_.routes->advance(t0_);
+
+    if constexpr (serializable_region<R>) {
+      if (opts_.trade_log) {
+        trace_scope scope(opts_.trace, "trade_log", t0_ - 1);
+        opts_.trade_log->write_step(t0_ - 1, changes_, [this](const R& region, uint_t t) { return status(region, t); });
+      }
+    }
+    changes_.clear();
+    added_.clear();
+    stopped_.clear();
+
+    if constexpr (serializable_region<R>) {
+      if (opts_.checkpoint && t0_ % std::max<uint_t>(opts_.checkpoint->every, 1) == 0)
+        checkpoint(opts_.checkpoint->path);
+    }
+  }
+
+  //! Advances the simulation until time `t` is reached or the stop criterion is satisfied.
+  auto run_until(uint_t t) -> void
+  {
+    while (t0_ < t && !finished())
+      step();
+    flush();
+  }
+
+  //! Advances the simulation until the stop criterion is satisfied.
+  auto run() -> void
+  {
+    while (!finished())
+      step();
+    flush();
+  }
+
+  //! Blocks until the reporting thread has delivered every step (see `simulation_opts_t::report_depth`).
+  auto flush() -> void
+  {
+    if (reporter_)
+      reporter_->flush();
+  }
+
+  //! Whether the stop criterion is satisfied.
+  //!
+  //! The criterion is only checked after the first step, so that the factory has the
+  //! chance to create agents.
+  auto finished() const -> bool
+  {
+    return t0_ > 0 && stop_.satisfied(t0_, agents_.active_count());
+  }
+
+  //! The current time step, i.e., the time of the next call to \ref step.
+  auto time() const -> uint_t { return t0_; }
+
+  //! Private status of the agents in the simulation.
+  auto agents() const -> const agents_private_status_t& { return agents_; }
+
+  //! Options used to configure the simulation.
+  auto options() const -> const simulation_opts_t<R>& { return opts_; }
+
+  //! Metrics of the last step (see \ref metrics_enabled).
+  auto metrics() const -> const simulation_metrics_t& { return metrics_; }
+
+  //! Private status of a permit.
+  //!
+  //! Unlike the book accessed by agents, this lookup never creates entries: permits not
+  //! stored in the book are reported with their initial status.
+  auto status(region_view loc, uint_t t) const -> permit_private_status_t
+  {
+    const auto* status = find(loc, t);
+    return status ? *status : permit_private_status_t{};
+  }
+
+  //! Statistics of the trades in a region in the last `options().market_window` steps.
+  auto market(const R& region) const -> const market_stats_t& { return market_.stats(region); }
+
+  //! \brief Visits the permits in the time range `[t_begin, t_end)` whose regions are in the query.
+  //!
+  //! The function receives the region, the time and the private status of each permit.  Only
+  //! permits that have been bid, asked or traded are visited: any other permit is on sale by
+  //! nobody, with no history.  Regions with an \ref ordered_book (such as \ref voxel) scan only
+  //! the key ranges that overlap \ref ordered_region_query queries; otherwise, every permit of the
+  //! visited time steps is tested against the query.
+  template <region_query<R> Q, typename F> auto query(const Q& query, uint_t t_begin, uint_t t_end, F&& f) const -> void
+  {
+    const auto last = std::min<uint_t>(t_end, t0_ + data_.size());
+    for (auto t = std::max(t_begin, t0_); t < last; ++t)
+      for_each_in(data_[t - t0_], query, [&](const R& region, const permit_private_status_t& status) { f(region, t, status); });
+  }
+
+  //! Writes the complete state of the simulation to a binary stream.
+  //!
+  //! Requires agents that override `agent::serialize`.
+  auto save(std::ostream& os) const -> void requires serializable_region<R>
+  {
+    write_binary(os, checkpoint_magic);
+    write_binary(os, t0_);
+
+    std::ostringstream rnd_state;
+    rnd_state << rnd_;
+    write_string(os, rnd_state.str());
+
+    agents_.serialize(os);
+    stop_.serialize(os);
+
+    // Bucket i of the book holds the permits at time t0 + i, so times need not be stored.
+    write_binary(os, data_.size());
+    for (const auto& bucket : data_) {
+      write_binary(os, bucket.size());
+      bucket.for_each([&](const R& region, const permit_private_status_t& status) {
+        region_serializer<R>::write(os, region);
+        write_permit_status(os, status);
+      });
+    }
+
+    market_.save(os);
+  }
+
+  //! Restores the state of the simulation from a binary stream written by \ref save.
+  //!
+  //! Agents are restored with `options().agent_deserializer`.
+  auto load(std::istream& is) -> void requires serializable_region<R>
+  {
+    if (read_binary<std::uint64_t>(is) != checkpoint_magic)
+      throw std::runtime_error{"invalid or incompatible checkpoint"};
+    t0_ = read_binary<uint_t>(is);
+
+    std::istringstream rnd_state(read_string(is));
+    rnd_state >> rnd_;
+
+    agents_.deserialize(is, opts_.agent_deserializer);
+    stop_.deserialize(is);
+
+    for (auto& bucket : data_)
+      drop_bucket(std::move(bucket));
+    data_.clear();
+
+    const auto size = read_binary<std::size_t>(is);
+    for (uint_t i = 0; i < size; ++i) {
+      auto& bucket = data_.emplace_back(new_bucket());
+      const auto count = read_binary<std::size_t>(is);
+      bucket.reserve(count);
+      for (std::size_t j = 0; j < count; ++j) {
+        const auto region = region_serializer<R>::read(is);
+        bucket.get(region).first = read_permit_status(is);
+      }
+    }
+
+    market_.load(is);
+  }
+
+  //! Writes the complete state of the simulation to a file.
+  //!
+  //! The checkpoint is written to a temporary file that atomically replaces `path`.
+  auto checkpoint(const std::filesystem::path& path) const -> void requires serializable_region<R>
+  {
+    auto tmp = path;
+    tmp += ".tmp";
+    {
+      std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+      save(os);
+      if (!os.flush())
+        throw std::runtime_error{"could not write checkpoint file"};
+    }
+    std::filesystem::rename(tmp, path);
+  }
+
+private:
+  // Changes are only recorded for the delta callback and the trade log.
+  auto recording_changes() const -> bool { return opts_.delta_callback || opts_.trade_log; }
+
+  auto outside_limits(uint_t t) const -> bool
+  {
+    // XXX agents can check the state at t0, however they should be prohibited to bid for.
+    return t < t0_ || (opts_.time_window && t > t0_ + 1 + *opts_.time_window);
+  }
+
+  // Lookup that never creates entries; returns null for permits not stored in the book.
+  auto find(region_view loc, uint_t t) const -> const permit_private_status_t*
+  {
+    if (outside_limits(t))
+      return &ool_;
+    if (t - t0_ >= data_.size())
+      return nullptr;
+    return data_[t - t0_].find(loc.downcast<R>());
+  }
+
+  auto book(region_view loc, uint_t t) -> permit_private_status_t&
+  {
+    if (outside_limits(t))
+      return ool_;
+    count_metric(metrics_.book_lookups);
+    while (t - t0_ >= data_.size())
+      data_.push_back(new_bucket());
+    const auto [status, inserted] = data_[t - t0_].get(loc.downcast<R>());
+    count_metric(metrics_.book_materializations, inserted);
+    return status;
+  }
+
+  // Buckets of past time steps are kept by the simulation for later steps, so that the book does
+  // not allocate new buckets in the steady state, whatever the memory resource.
+  auto new_bucket() -> book_bucket_t<R>
+  {
+    if (spare_.empty())
+      return acquire_bucket<R>(data_.get_allocator().resource());
+    auto bucket = std::move(spare_.back());
+    spare_.pop_back();
+    return bucket;
+  }
+
+  auto drop_bucket(book_bucket_t<R>&& bucket) -> void
+  {
+    bucket.clear();
+    spare_.push_back(std::move(bucket));
+  }
+
+  // Finding the set of bundles with the highest total value is NP-hard, so bundles are awarded
+  // greedily in decreasing order of total value.  A bundle wins if all of its items beat the
+  // highest single bids and none of its permits was claimed by a previous bundle.
+  auto award_bundles() -> void
+  {
+    // Bundles are stored in submission order, and so are their items (unlike std::stable_sort,
+    // this does not allocate).
+    std::ranges::sort(bundles_, [](const bundle_t& a, const bundle_t& b) {
+      return a.total != b.total ? a.total > b.total : a.first < b.first;
+    });
+    claimed_.clear();
+    for (const auto& bundle : bundles_) {
+      const auto items = std::span(bundle_items_).subspan(bundle.first, bundle.count);
+      const auto beats = [&](const auto& item) {
+        const auto& [location, time, value] = item;
+        const auto& status = std::get<permit_private_status::on_sale>(book(location, time).current);
+        return value > status.highest_bid && !claimed_.contains({location, time});
+      };
+      if (!std::ranges::all_of(items, beats))
+        continue;
+
+      // A bundle with the same permit twice conflicts with itself.
+      std::size_t n = 0;
+      while (n < items.size() && claimed_.emplace(std::get<0>(items[n]), std::get<1>(items[n])).second)
+        ++n;
+      if (n < items.size()) {
+        for (std::size_t i = 0; i < n; ++i)
+          claimed_.erase({std::get<0>(items[i]), std::get<1>(items[i])});
+        continue;
+      }
+
+      count_metric(metrics_.bundles_awarded);
+      for (const auto& [location, time, value] : items) {
+        auto& status = std::get<permit_private_status::on_sale>(book(location, time).current);
+        if (status.highest_bidder == no_owner)
+          bids_.emplace_back(location, time);
+        status.highest_bidder = bundle.agent;
+        status.highest_bid = value;
+      }
+    }
+  }
+
+  // Queries do not materialize permits, so agents exploring many permits (e.g., with a route
+  // planner) do not grow the book.
+  auto public_access(id_t id, uint_t& lookups) const
+  {
+    return [id, &lookups, this](region_view s, uint_t t) -> permit_public_status_t {
+      using namespace permit_private_status;
+      using namespace permit_public_status;
+      static const permit_private_status_t unlisted{};
+      const auto* found = find(s, t);
+      count_metric(lookups, found != &ool_);
+      const auto& pstatus = found ? *found : unlisted;
+      return std::visit(
+        cool::compose{
+          [](out_of_limits) -> permit_public_status_t { return unavailable{}; },
+          [&](in_use status) -> permit_public_status_t {
+            return status.owner == id ? permit_public_status_t{owned{}} : unavailable{};
+          },
+          [&](on_sale status) -> permit_public_status_t {
+            if (status.owner == id)
+              return unavailable{};
+            return available{status.min_value, pstatus.history, pstatus.market, market_.stats(s.template downcast<R>())};
+          }},
+        pstatus.current);
+    };
+  }
+
+  using ask_buffer_t = std::pmr::vector<std::tuple<R, uint_t, uint_t, value_t>>;
+
+  // Counters of the ask phase, kept apart from the metrics so that workers do not share them.
+  struct ask_counters_t
+  {
+    uint_t accepted = 0, rejected = 0, lookups = 0;
+  };
+
+  // Runs the ask phase of an agent.  Asks are deferred and the book is only read, so the
+  // phase of different agents can run concurrently.
+  auto agent_ask_phase(id_t id, int seed, ask_buffer_t& asks, ask_counters_t& counters, tracer* agent_trace) -> void
+  {
+    auto ask = [&](region_view s, uint_t t, value_t v) -> bool {
+      using namespace permit_private_status;
+      const auto* found = find(s, t);
+      count_metric(counters.lookups, found != &ool_);
+      const auto owner =
+        cool::compose{[](const out_of_limits&) { return false; }, [&](const auto& status) { return status.owner == id; }};
+      const auto result = found && std::visit(owner, found->current);
+      if (result)
+        asks.emplace_back(s.downcast<R>(), t, id, v);
+      count_metric(result ? counters.accepted : counters.rejected);
+      return result;
+    };
+
+    auto access = public_access(id, counters.lookups);
+    trace_scope agent_scope(agent_trace, "ask_phase", t0_, id);
+    agents_.at(id).ask_phase(t0_, ask_fn(ask), permit_public_status_fn(access), seed);
+  }
+
+  // Runs the ask phase of contiguous ranges of agents in the pool.  Seeds are drawn in the
+  // order of the sequential phase and the asks are merged in agent order, so the outcome does
+  // not depend on the number of threads.
+  auto parallel_ask_phase(tracer* agent_trace) -> void
+  {
+    const auto active = agents_.active();
+    draw_seeds(active.size());
+
+    const auto chunks = parallel_chunks(active.size());
+    while (ask_chunks_.size() < chunks)
+      ask_chunks_.push_back({ask_buffer_t(resource(opts_.memory.transient)), {}});
+    parallel_for(active.size(), chunks, [&](std::size_t c, std::size_t begin, std::size_t end) {
+      auto& [asks, counters] = ask_chunks_[c];
+      asks.clear();
+      counters = {};
+      for (auto i = begin; i < end; ++i)
+        agent_ask_phase(active[i], seeds_[i], asks, counters, agent_trace);
+    });
+
+    ask_counters_t total;
+    for (std::size_t c = 0; c < chunks; ++c) {
+      const auto& [asks, counters] = ask_chunks_[c];
+      asks_.insert(asks_.end(), asks.begin(), asks.end());
+      total.accepted += counters.accepted;
+      total.rejected += counters.rejected;
+      total.lookups += counters.lookups;
+    }
+    count_ask_metrics(total);
+  }
+
+  auto count_ask_metrics([[maybe_unused]] const ask_counters_t& counters) -> void
+  {
+    count_metric(metrics_.asks_accepted, counters.accepted);
+    count_metric(metrics_.asks_rejected, counters.rejected);
+    count_metric(metrics_.book_lookups, counters.lookups);
+  }
+
+  // Evaluates the stop criterion of contiguous ranges of agents in the pool.  Each range lists
+  // the positions of its agents that stop, and the lists are concatenated in agent order.
+  auto parallel_stop_phase() -> void
+  {
+    const auto active = agents_.active();
+    draw_seeds(active.size());
+
+    const auto chunks = parallel_chunks(active.size());
+    while (stop_chunks_.size() < chunks)
+      stop_chunks_.emplace_back();
+    parallel_for(active.size(), chunks, [&](std::size_t c, std::size_t begin, std::size_t end) {
+      auto& stopped = stop_chunks_[c];
+      stopped.clear();
+      for (auto i = begin; i < end; ++i)
+        if (agents_.at(active[i]).stop(t0_, seeds_[i]))
+          stopped.push_back(i);
+    });
+
+    for (std::size_t c = 0; c < chunks; ++c)
+      stopped_positions_.insert(stopped_positions_.end(), stop_chunks_[c].begin(), stop_chunks_[c].end());
+  }
+
+  // Delivers the trades of the step to the agents in the pool.  Trades are grouped by agent and
+  // each group is delivered by a single worker, in the order of the sequential settlement.
+  auto parallel_settlement() -> void
+  {
+    trace_scope scope(opts_.trace, "settlement", t0_);
+    std::ranges::sort(settlements_, {}, [](const settlement_t& x) { return std::pair{x.agent, x.order}; });
+
+    // Ranges start at the first trade of an agent, so that no agent is shared by two workers.
+    const auto n = settlements_.size();
+    const auto align = [&](std::size_t i) {
+      while (i > 0 && i < n && settlements_[i].agent == settlements_[i - 1].agent)
+        ++i;
+      return i;
+    };
+    parallel_for(n, parallel_chunks(n), [&](std::size_t, std::size_t begin, std::size_t end) {
+      for (auto i = align(begin); i < align(end); ++i) {
+        const auto& [agent, order, trade, value, sold] = settlements_[i];
+        const auto& [s, t] = bids_[trade];
+        if (sold)
+          agents_.at(agent).on_sold(s, t, value);
+        else
+          agents_.at(agent).on_bought(s, t, value);
+      }
+    });
+  }
+
+  // Draws one seed per agent, in the order in which the sequential phases draw them.
+  auto draw_seeds(std::size_t n) -> void
+  {
+    seeds_.clear();
+    for (std::size_t i = 0; i < n; ++i)
+      seeds_.push_back(rnd_());
+  }
+
+  // Number of ranges in which parallel phases split `n` agents (a few per worker, for balance).
+  auto parallel_chunks(std::size_t n) const -> std::size_t { return std::min(n, 4 * opts_.pool->size()); }
+
+  // Runs `f(chunk, begin, end)` in the pool for each of `chunks` contiguous ranges covering `[0, n)`.
+  template <typename F> auto parallel_for(std::size_t n, std::size_t chunks, F&& f) -> void
+  {
+    for (std::size_t c = 0; c < chunks; ++c)
+      opts_.pool->submit([&f, c, n, chunks] { f(c, c * n / chunks, (c + 1) * n / chunks); });
+    opts_.pool->wait();
+  }
+
+  simulation_opts_t<R> opts_;
+  std::mt19937 rnd_;
+
+  static auto resource(std::pmr::memory_resource* resource) -> std::pmr::memory_resource*
+  {
+    return resource ? resource : std::pmr::get_default_resource();
+  }
+
+  agents_private_status_t agents_{resource(opts_.memory.agents)};
+  std::pmr::vector<std::size_t> stopped_positions_{resource(opts_.memory.agents)};
+
+  uint_t t0_ = 0;
+  stop_condition_t stop_;
+
+  book_data_t<R> data_{resource(opts_.memory.book)};
+  std::pmr::vector<book_bucket_t<R>> spare_{resource(opts_.memory.book)};
+  permit_private_status_t ool_ = {permit_private_status::out_of_limits{}, {}};
+  region_market<R> market_{opts_.market_window, resource(opts_.memory.book)};
+
+  std::pmr::vector<permit<R>> bids_{resource(opts_.memory.transient)};
+  ask_buffer_t asks_{resource(opts_.memory.transient)};
+  std::pmr::vector<std::pair<ask_buffer_t, ask_counters_t>> ask_chunks_{resource(opts_.memory.transient)};
+  std::pmr::vector<int> seeds_{resource(opts_.memory.transient)};
+  std::pmr::vector<std::pmr::vector<std::size_t>> stop_chunks_{resource(opts_.memory.transient)};
+
+  // A trade to be delivered to an agent by the parallel settlement.
+  struct settlement_t
+  {
+    id_t agent;
+    std::size_t order; // Position in the sequential settlement.
+    std::size_t trade; // Index of the permit in bids_.
+    value_t value;
+    bool sold;
+  };
+  std::pmr::vector<settlement_t> settlements_{resource(opts_.memory.transient)};
+
+  struct bundle_t
+  {
+    id_t agent;
+    value_t total;
+    std::size_t first, count;
+  };
+  std::pmr::vector<bundle_t> bundles_{resource(opts_.memory.transient)};
+  std::pmr::vector<std::tuple<R, uint_t, value_t>> bundle_items_{resource(opts_.memory.transient)};
+  std::pmr::unordered_set<permit<R>> claimed_{resource(opts_.memory.transient)};
+
+  std::pmr::vector<permit_change_t<R>> changes_{resource(opts_.memory.transient)};
+  std::pmr::vector<id_t> added_{resource(opts_.memory.transient)}, stopped_{resource(opts_.memory.transient)};
+  std::unique_ptr<report_pipeline<R>> reporter_;
+  step_report_t<R> report_;
+
+  simulation_metrics_t metrics_;
+};
+
+//! A simulation of a first-price sealed-bid auction.
+//!
+//! \param opts Options to configure the simulation.
+//!
+//! Runs a \ref simulation until its stop criterion is satisfied.
+//!
+//! If `opts.checkpoint` is set, the complete state of the simulation (book, trade histories,
+//! agents, random engine and current time) is written every `opts.checkpoint->every` steps.
+//! A simulation started with `opts.resume_from` continues exactly where the checkpoint was
+//! taken, provided the remaining options are the same.  Both require a \ref serializable_region
+//! and agents that override `agent::serialize`.
+template <region_compatible R> auto simulate(const simulation_opts_t<R>& opts = {}) -> void { simulation<R>(opts).run(); }
 
 } // namespace uat
 
@@ -0,0 +1,87 @@
+//! \file thread_pool.hpp
+//! \brief Defines a work-stealing thread pool used to parallelize simulations.
+
+#ifndef UAT_THREAD_POOL_HPP
+#define UAT_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace uat
+{
+
+//! \brief A fixed-size pool of worker threads with work stealing.
+//!
+//! Each worker owns a task queue.  Tasks submitted from a worker go to its own queue
+//! and are executed in LIFO order, while idle workers steal the oldest tasks from the
+//! other queues.  Tasks submitted from outside the pool are distributed round-robin.
+class thread_pool
+{
+public:
+  //! Value returned by \ref worker_index when the caller is not a worker of any pool.
+  static constexpr auto no_worker = std::numeric_limits<std::size_t>::max();
+
+  //! Starts a pool with the given number of worker threads (at least one).
+  explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency());
+
+  //! Executes the pending tasks and joins all workers.
+  ~thread_pool();
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool(thread_pool&&) = delete;
+
+  auto operator=(const thread_pool&) -> thread_pool& = delete;
+  auto operator=(thread_pool&&) -> thread_pool& = delete;
+
+  //! Number of worker threads.
+  auto size() const noexcept -> std::size_t;
+
+  //! Schedules a task for execution.
+  auto submit(std::function<void()> task) -> void;
+
+  //! Blocks until all submitted tasks are finished.
+  //!
+  //! If any task has thrown, the first exception is rethrown here.
+  //!
+  //! \note Must not be called from a worker of this pool.
+  auto wait() -> void;
+
+  //! Index in [0, size()) of the calling worker, or \ref no_worker if the caller is not a worker.
+  static auto worker_index() noexcept -> std::size_t;
+
+private:
+  //! \private
+  struct worker_queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  auto try_pop(std::size_t, std::function<void()>&) -> bool;
+  auto work(std::size_t) -> void;
+
+  std::vector<std::unique_ptr<worker_queue>> queues_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  std::size_t queued_ = 0;
+  std::size_t pending_ = 0;
+  std::size_t next_queue_ = 0;
+  bool stopping_ = false;
+  std::exception_ptr error_;
+
+  std::vector<std::thread> workers_;
+};
+
+} // namespace uat
+
+#endif // UAT_THREAD_POOL_HPP
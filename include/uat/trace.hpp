@@ -0,0 +1,124 @@
+//! \file trace.hpp
+//! \brief Defines a tracer that records timelines of the simulation phases.
+
+#ifndef UAT_TRACE_HPP
+#define UAT_TRACE_HPP
+
+#include <uat/type.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace uat
+{
+
+//! \brief Records begin and end of simulation phases and exports them as a Chrome trace.
+//!
+//! Each thread that records events gets its own buffer, so recording never takes locks
+//! (a mutex is only taken the first time a thread records into a tracer, and when a thread
+//! alternates between more tracers than it remembers).  The events can be written in the
+//! Chrome trace event format, which is understood by `chrome://tracing` and Perfetto.
+//!
+//! A tracer is attached to a simulation through `simulation_opts_t::trace`; when no
+//! tracer is attached, the instrumentation costs a single branch.
+class tracer
+{
+public:
+  //! Value used for events not associated with an agent.
+  static constexpr auto no_agent = std::numeric_limits<id_t>::max();
+
+  //! A complete event, i.e., a named interval of time.
+  struct event
+  {
+    const char* name;   //!< Name of the event (must have static storage duration).
+    std::int64_t begin; //!< Begin of the event in nanoseconds since the creation of the tracer.
+    std::int64_t end;   //!< End of the event in nanoseconds since the creation of the tracer.
+    uint_t step;        //!< Time step of the simulation.
+    id_t agent;         //!< Agent associated with the event or \ref no_agent.
+  };
+
+  //! Creates a tracer.
+  //!
+  //! \param agent_events Whether the bid and ask phases of each agent are recorded as well.
+  explicit tracer(bool agent_events = false);
+
+  tracer(const tracer&) = delete;
+  tracer(tracer&&) = delete;
+
+  auto operator=(const tracer&) -> tracer& = delete;
+  auto operator=(tracer&&) -> tracer& = delete;
+
+  ~tracer();
+
+  //! Whether the phases of each agent are recorded.
+  auto agent_events() const noexcept -> bool { return agent_events_; }
+
+  //! Current time in nanoseconds since the creation of the tracer.
+  auto now() const noexcept -> std::int64_t
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin_).count();
+  }
+
+  //! Records an event in the buffer of the calling thread.
+  auto record(const event& e) -> void;
+
+  //! Writes all recorded events as a Chrome trace JSON document.
+  //!
+  //! \note Must not be called while other threads are recording.
+  auto write(std::ostream& os) const -> void;
+
+  //! Writes all recorded events as a Chrome trace JSON file.
+  auto save(const std::filesystem::path& path) const -> void;
+
+private:
+  //! \private
+  struct buffer;
+
+  auto local_buffer() -> buffer&;
+
+  bool agent_events_;
+  std::uint64_t id_;
+  std::chrono::steady_clock::time_point origin_;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<buffer>> buffers_;
+};
+
+//! \private
+//! Records the lifetime of the object as an event when a tracer is given.
+class trace_scope
+{
+public:
+  trace_scope(tracer* t, const char* name, uint_t step, id_t agent = tracer::no_agent) noexcept
+    : tracer_(t), name_(name), step_(step), agent_(agent)
+  {
+    if (tracer_)
+      begin_ = tracer_->now();
+  }
+
+  trace_scope(const trace_scope&) = delete;
+  auto operator=(const trace_scope&) -> trace_scope& = delete;
+
+  ~trace_scope()
+  {
+    if (tracer_)
+      tracer_->record({name_, begin_, tracer_->now(), step_, agent_});
+  }
+
+private:
+  tracer* tracer_;
+  const char* name_;
+  uint_t step_;
+  id_t agent_;
+  std::int64_t begin_ = 0;
+};
+
+} // namespace uat
+
+#endif // UAT_TRACE_HPP
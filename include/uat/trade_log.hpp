@@ -0,0 +1,349 @@
+//! \file trade_log.hpp
+//! \brief Defines a log of the changes of the book, and its replay at any time step.
+
+#ifndef UAT_TRADE_LOG_HPP
+#define UAT_TRADE_LOG_HPP
+
+#include <uat/book.hpp>
+#include <uat/serialization.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace uat
+{
+
+//! \private
+namespace trade_log_format
+{
+
+constexpr std::uint64_t magic = 0x01474f4c54415500; // "\0UATLOG" followed by the format version.
+
+//! Kinds of blocks in a log.  Every block starts with its kind, its time step and the size of its payload.
+enum class block : std::uint8_t
+{
+  keyframe, //!< The permits in the book at the beginning of a step.
+  step,     //!< The changes of the permits in a step.
+  index     //!< The offsets of the keyframes, written when the log is closed.
+};
+
+constexpr std::size_t header_size = sizeof(block) + sizeof(uint_t) + sizeof(std::uint64_t);
+
+} // namespace trade_log_format
+
+//! \brief The book of a simulation at the beginning of a time step, rebuilt from a trade log.
+//!
+//! Permits not stored in the book are on sale by nobody, with no history.
+template <region_compatible R> class book_snapshot
+{
+public:
+  //! Constructs an empty book at the beginning of a step.
+  explicit book_snapshot(uint_t time = 0) : time_(time) {}
+
+  //! The time step of the book.
+  auto time() const -> uint_t { return time_; }
+
+  //! Number of permits stored in the book.
+  auto size() const -> std::size_t { return permits_.size(); }
+
+  //! Private status of a permit (permits before \ref time are reported out of limits).
+  auto status(const R& location, uint_t time) const -> permit_private_status_t
+  {
+    if (time < time_)
+      return {permit_private_status::out_of_limits{}, {}};
+    const auto it = permits_.find({location, time});
+    return it == permits_.end() ? permit_private_status_t{} : it->second;
+  }
+
+  //! Visits every permit stored in the book, in no particular order.
+  template <typename F> auto for_each(F&& f) const -> void
+  {
+    for (const auto& [permit, status] : permits_)
+      f(permit.location, permit.time, status);
+  }
+
+  //! \private
+  auto set(permit<R> p, permit_private_status_t status) -> void { permits_.insert_or_assign(std::move(p), std::move(status)); }
+
+  //! \private
+  auto erase(const permit<R>& p) -> void { permits_.erase(p); }
+
+private:
+  uint_t time_;
+  std::unordered_map<permit<R>, permit_private_status_t> permits_;
+};
+
+//! \brief Writes the changes of the book of a simulation to a file (see `simulation_opts_t::trade_log`).
+//!
+//! The log holds the changes of every step, as reported to the delta callback, together with
+//! the status of each traded or asked permit after the step.  Every `keyframe_every` steps, the
+//! whole book is also written, so that \ref trade_log_reader can rebuild the book at any step
+//! by applying the changes of at most `keyframe_every` steps.  When the log is closed, an index
+//! of the keyframes is appended to the file; logs of interrupted runs are indexed when opened.
+template <region_compatible R> class trade_log_writer
+{
+public:
+  //! Creates (or replaces) the log file.
+  //!
+  //! \throws std::runtime_error if the file cannot be opened.
+  explicit trade_log_writer(const std::filesystem::path& path, uint_t keyframe_every = 1024) requires serializable_region<R>
+    : os_(path, std::ios::binary | std::ios::trunc), every_(std::max<uint_t>(keyframe_every, 1))
+  {
+    if (!os_)
+      throw std::runtime_error{"could not open trade log file"};
+    write_binary(os_, trade_log_format::magic);
+  }
+
+  trade_log_writer(const trade_log_writer&) = delete;
+  auto operator=(const trade_log_writer&) -> trade_log_writer& = delete;
+
+  //! Closes the log, if not closed yet.
+  ~trade_log_writer()
+  {
+    try {
+      close();
+    } catch (...) {
+      // The log can still be read without its index.
+    }
+  }
+
+  //! Whether a keyframe should be written at the beginning of a step.
+  auto wants_keyframe(uint_t step) const -> bool
+  {
+    return keyframes_.empty() || (step % every_ == 0 && keyframes_.back().first != step);
+  }
+
+  //! \brief Writes the book at the beginning of a step.
+  //!
+  //! `visit(f)` must call `f(region, time, status)` for every permit stored in the book.
+  template <typename Visit> auto write_keyframe(uint_t step, Visit&& visit) -> void requires serializable_region<R>
+  {
+    keyframes_.emplace_back(step, static_cast<std::uint64_t>(os_.tellp()));
+    const auto payload = begin_block(trade_log_format::block::keyframe, step);
+    std::uint64_t written = 0;
+    write_binary(os_, written);
+    visit([&](const R& region, uint_t time, const permit_private_status_t& status) {
+      region_serializer<R>::write(os_, region);
+      write_binary(os_, time);
+      write_permit_status(os_, status);
+      ++written;
+    });
+    end_block(payload, written);
+  }
+
+  //! \brief Writes the changes of a step.
+  //!
+  //! `status(region, time)` must return the private status of a permit after the step.
+  template <typename Lookup>
+  requires serializable_region<R>
+  auto write_step(uint_t step, std::span<const permit_change_t<R>> changes, Lookup&& status) -> void
+  {
+    const auto payload = begin_block(trade_log_format::block::step, step);
+    write_binary(os_, static_cast<std::uint64_t>(changes.size()));
+    for (const auto& change : changes) {
+      write_binary(os_, change.kind);
+      region_serializer<R>::write(os_, change.location);
+      write_binary(os_, change.time);
+      if (change.kind != permit_change::expired)
+        write_permit_status(os_, status(change.location, change.time));
+    }
+    end_block(payload, changes.size());
+    end_ = step + 1;
+  }
+
+  //! Writes the index of the keyframes and closes the file.
+  auto close() -> void
+  {
+    if (!os_.is_open())
+      return;
+    const auto offset = static_cast<std::uint64_t>(os_.tellp());
+    const auto payload = begin_block(trade_log_format::block::index, end_);
+    write_binary(os_, static_cast<std::uint64_t>(keyframes_.size()));
+    for (const auto& [step, position] : keyframes_) {
+      write_binary(os_, step);
+      write_binary(os_, position);
+    }
+    end_block(payload, keyframes_.size());
+    write_binary(os_, offset);
+    write_binary(os_, trade_log_format::magic);
+    os_.close();
+    if (!os_)
+      throw std::runtime_error{"could not write trade log file"};
+  }
+
+private:
+  // Writes the header of a block, returning the position of its payload.
+  auto begin_block(trade_log_format::block kind, uint_t step) -> std::streamoff
+  {
+    write_binary(os_, kind);
+    write_binary(os_, step);
+    write_binary(os_, std::uint64_t{0}); // Patched by end_block.
+    return os_.tellp();
+  }
+
+  // Patches the size of the payload of the current block and the number of entries at its beginning.
+  auto end_block(std::streamoff payload, std::uint64_t count) -> void
+  {
+    const auto end = os_.tellp();
+    os_.seekp(payload - static_cast<std::streamoff>(sizeof(std::uint64_t)));
+    write_binary(os_, static_cast<std::uint64_t>(end - payload));
+    write_binary(os_, count);
+    os_.seekp(end);
+  }
+
+  std::ofstream os_;
+  uint_t every_;
+  uint_t end_ = 0;
+  std::vector<std::pair<uint_t, std::uint64_t>> keyframes_; // Step and file offset of each keyframe.
+};
+
+//! \brief Rebuilds the book of a simulation at any step from a log written by \ref trade_log_writer.
+//!
+//! Example (the book at step 123456 of a long run):
+//! \code
+//! uat::trade_log_reader<Point> log("run.log");
+//! const auto book = log.book_at(123456);
+//! book.for_each([](const Point& p, uat::uint_t t, const uat::permit_private_status_t& status) { ... });
+//! \endcode
+template <region_compatible R> class trade_log_reader
+{
+public:
+  //! Opens a log and reads the index of its keyframes.
+  //!
+  //! \throws std::runtime_error if the file cannot be opened or is not a trade log.
+  explicit trade_log_reader(const std::filesystem::path& path) requires serializable_region<R> : is_(path, std::ios::binary)
+  {
+    if (!is_ || read_binary<std::uint64_t>(is_) != trade_log_format::magic)
+      throw std::runtime_error{"invalid or incompatible trade log"};
+    if (!read_index())
+      scan();
+  }
+
+  //! The first step whose book can be rebuilt.
+  auto first_step() const -> uint_t { return keyframes_.empty() ? end_ : keyframes_.front().first; }
+
+  //! The step after the last step in the log, whose book can also be rebuilt.
+  auto end_step() const -> uint_t { return end_; }
+
+  //! Rebuilds the book at the beginning of a step, from the nearest keyframe before it.
+  //!
+  //! \throws std::out_of_range if the step is not in `[first_step(), end_step()]`.
+  auto book_at(uint_t step) -> book_snapshot<R> requires serializable_region<R>
+  {
+    if (keyframes_.empty() || step < first_step() || step > end_step())
+      throw std::out_of_range{"step not covered by the trade log"};
+
+    const auto keyframe = std::ranges::upper_bound(keyframes_, step, {}, &std::pair<uint_t, std::uint64_t>::first) - 1;
+    is_.clear();
+    is_.seekg(static_cast<std::streamoff>(keyframe->second));
+
+    book_snapshot<R> book(step);
+    for (auto header = read_header(); header; header = read_header()) {
+      const auto [kind, time, size] = *header;
+      if (kind == trade_log_format::block::index || (kind == trade_log_format::block::step && time >= step))
+        break;
+      if (kind == trade_log_format::block::keyframe && time != keyframe->first) {
+        is_.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+        continue;
+      }
+
+      const auto count = read_binary<std::uint64_t>(is_);
+      for (std::uint64_t i = 0; i < count; ++i) {
+        const auto change = kind == trade_log_format::block::step ? read_binary<permit_change>(is_) : permit_change::traded;
+        auto p = permit<R>{region_serializer<R>::read(is_), read_binary<uint_t>(is_)};
+        if (change == permit_change::expired)
+          book.erase(p);
+        else
+          book.set(std::move(p), read_permit_status(is_));
+      }
+    }
+    return book;
+  }
+
+private:
+  struct header_t
+  {
+    trade_log_format::block kind;
+    uint_t step;
+    std::uint64_t size;
+  };
+
+  // Returns nothing at the end of the file or on a truncated header.
+  auto read_header() -> std::optional<header_t>
+  {
+    header_t header;
+    is_.read(reinterpret_cast<char*>(&header.kind), sizeof(header.kind));
+    is_.read(reinterpret_cast<char*>(&header.step), sizeof(header.step));
+    is_.read(reinterpret_cast<char*>(&header.size), sizeof(header.size));
+    if (!is_)
+      return std::nullopt;
+    return header;
+  }
+
+  // Reads the index written when the log was closed; returns false if there is none.
+  auto read_index() -> bool
+  {
+    is_.seekg(-static_cast<std::streamoff>(2 * sizeof(std::uint64_t)), std::ios::end);
+    std::uint64_t trailer[2];
+    if (!is_.read(reinterpret_cast<char*>(trailer), sizeof(trailer)) || trailer[1] != trade_log_format::magic) {
+      is_.clear();
+      return false;
+    }
+    is_.seekg(static_cast<std::streamoff>(trailer[0]));
+    const auto header = read_header();
+    if (!header || header->kind != trade_log_format::block::index)
+      throw std::runtime_error{"invalid trade log index"};
+    end_ = header->step;
+    keyframes_.resize(read_binary<std::uint64_t>(is_));
+    for (auto& [step, offset] : keyframes_) {
+      step = read_binary<uint_t>(is_);
+      offset = read_binary<std::uint64_t>(is_);
+    }
+    return true;
+  }
+
+  // Indexes a log without index by skipping from block to block; incomplete blocks are ignored.
+  auto scan() -> void
+  {
+    is_.seekg(static_cast<std::streamoff>(sizeof(trade_log_format::magic)));
+    const auto file_size = [&] {
+      const auto position = is_.tellg();
+      is_.seekg(0, std::ios::end);
+      const auto size = is_.tellg();
+      is_.seekg(position);
+      return size;
+    }();
+
+    for (;;) {
+      const auto offset = is_.tellg();
+      const auto header = read_header();
+      // Blocks are complete once their size is patched, and every payload starts with a count.
+      if (!header || header->kind > trade_log_format::block::index || header->size < sizeof(std::uint64_t) ||
+          offset + static_cast<std::streamoff>(trade_log_format::header_size + header->size) > file_size)
+        break;
+      if (header->kind == trade_log_format::block::keyframe)
+        keyframes_.emplace_back(header->step, static_cast<std::uint64_t>(offset));
+      else if (header->kind == trade_log_format::block::step)
+        end_ = header->step + 1;
+      is_.seekg(static_cast<std::streamoff>(header->size), std::ios::cur);
+    }
+    if (!keyframes_.empty())
+      end_ = std::max(end_, keyframes_.back().first);
+  }
+
+  std::ifstream is_;
+  uint_t end_ = 0;
+  std::vector<std::pair<uint_t, std::uint64_t>> keyframes_; // Step and file offset of each keyframe.
+};
+
+} // namespace uat
+
+#endif // UAT_TRADE_LOG_HPP
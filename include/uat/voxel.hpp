@@ -0,0 +1,180 @@
+//! \file voxel.hpp
+//! \brief Defines a built-in region type for three-dimensional grid airspaces.
+
+#ifndef UAT_VOXEL_HPP
+#define UAT_VOXEL_HPP
+
+#include <uat/book.hpp>
+
+#include <cassert>
+#include <compare>
+#include <cstdint>
+
+namespace uat
+{
+
+//! \private
+namespace morton
+{
+
+inline constexpr std::uint64_t x_mask = 0x1249249249249249; //!< Bits of the x coordinate in a key.
+inline constexpr std::uint64_t y_mask = x_mask << 1;        //!< Bits of the y coordinate in a key.
+inline constexpr std::uint64_t z_mask = x_mask << 2;        //!< Bits of the z coordinate in a key.
+
+//! Spreads the 21 lowest bits of a coordinate so that there are two zeros between each bit.
+constexpr auto spread(std::uint64_t v) noexcept -> std::uint64_t
+{
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffff;
+  v = (v | v << 16) & 0x1f0000ff0000ff;
+  v = (v | v << 8) & 0x100f00f00f00f00f;
+  v = (v | v << 4) & 0x10c30c30c30c30c3;
+  v = (v | v << 2) & x_mask;
+  return v;
+}
+
+//! Inverse of \ref spread.
+constexpr auto compact(std::uint64_t v) noexcept -> std::uint32_t
+{
+  v &= x_mask;
+  v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3;
+  v = (v ^ (v >> 4)) & 0x100f00f00f00f00f;
+  v = (v ^ (v >> 8)) & 0x1f0000ff0000ff;
+  v = (v ^ (v >> 16)) & 0x1f00000000ffff;
+  v = (v ^ (v >> 32)) & 0x1fffff;
+  return static_cast<std::uint32_t>(v);
+}
+
+//! Interleaves three coordinates into a Morton key.
+constexpr auto encode(std::uint32_t x, std::uint32_t y, std::uint32_t z) noexcept -> std::uint64_t
+{
+  return spread(x) | spread(y) << 1 | spread(z) << 2;
+}
+
+//! \brief Smallest key greater than `key` inside the box `[min, max]`.
+//!
+//! Requires `min <= key <= max` and `key` outside the box (Tropf and Herzog's BIGMIN).
+constexpr auto next_in_box(std::uint64_t key, std::uint64_t min, std::uint64_t max) noexcept -> std::uint64_t
+{
+  // Sets bit i and clears the lower bits of the same dimension, or the opposite.
+  const auto load_min = [](std::uint64_t v, int i) {
+    const auto lower = (x_mask << (i % 3)) & ((std::uint64_t{1} << i) - 1);
+    return (v & ~lower) | std::uint64_t{1} << i;
+  };
+  const auto load_max = [](std::uint64_t v, int i) {
+    const auto lower = (x_mask << (i % 3)) & ((std::uint64_t{1} << i) - 1);
+    return (v | lower) & ~(std::uint64_t{1} << i);
+  };
+
+  std::uint64_t result = max;
+  for (int i = 62; i >= 0; --i) {
+    const auto bit = std::uint64_t{1} << i;
+    const bool k = key & bit, lo = min & bit, hi = max & bit;
+    if (!k && !lo && hi) {
+      result = load_min(min, i);
+      max = load_max(max, i);
+    } else if (!k && lo && hi) {
+      return min;
+    } else if (k && !lo && !hi) {
+      return result;
+    } else if (k && !lo && hi) {
+      min = load_min(min, i);
+    }
+  }
+  return result;
+}
+
+} // namespace morton
+
+//! \brief A cell of a three-dimensional grid airspace.
+//!
+//! Voxels are identified by their Morton (Z-order) key, which interleaves the bits of the
+//! coordinates.  Voxels are ordered by key, so cells that are close in space tend to be
+//! close in the book, and the simulation can answer \ref voxel_box queries by scanning
+//! contiguous key ranges (see `simulation::query`).
+//!
+//! Each coordinate must be at most \ref max_coordinate.
+class voxel
+{
+public:
+  static constexpr std::uint32_t max_coordinate = (1u << 21) - 1; //!< Largest value of each coordinate.
+
+  //! Constructs the voxel at the origin.
+  constexpr voxel() noexcept = default;
+
+  //! Constructs a voxel from its coordinates, where `z` is the altitude.
+  constexpr voxel(std::uint32_t x, std::uint32_t y, std::uint32_t z) noexcept : key_(morton::encode(x, y, z))
+  {
+    assert(x <= max_coordinate && y <= max_coordinate && z <= max_coordinate);
+  }
+
+  //! Constructs a voxel from its Morton key.
+  static constexpr auto from_key(std::uint64_t key) noexcept -> voxel
+  {
+    voxel v;
+    v.key_ = key;
+    return v;
+  }
+
+  constexpr auto x() const noexcept -> std::uint32_t { return morton::compact(key_); }      //!< The x coordinate.
+  constexpr auto y() const noexcept -> std::uint32_t { return morton::compact(key_ >> 1); } //!< The y coordinate.
+  constexpr auto z() const noexcept -> std::uint32_t { return morton::compact(key_ >> 2); } //!< The altitude.
+
+  //! The Morton key of the voxel.
+  constexpr auto key() const noexcept -> std::uint64_t { return key_; }
+
+  constexpr auto operator==(const voxel&) const noexcept -> bool = default;
+  constexpr auto operator<=>(const voxel&) const noexcept -> std::strong_ordering = default;
+
+private:
+  std::uint64_t key_ = 0;
+};
+
+//! \brief An axis-aligned box of voxels, with inclusive bounds.
+//!
+//! Example (all permits from the ground up to altitude 2 around the origin in the next 10 steps):
+//! \code
+//! sim.query(uat::voxel_box{{0, 0, 0}, {4, 4, 2}}, sim.time(), sim.time() + 10,
+//!           [](const uat::voxel& v, uat::uint_t t, const uat::permit_private_status_t& status) { ... });
+//! \endcode
+struct voxel_box
+{
+  voxel min; //!< The corner with the smallest coordinates.
+  voxel max; //!< The corner with the largest coordinates.
+
+  //! Whether the voxel is inside the box.
+  constexpr auto contains(const voxel& v) const noexcept -> bool
+  {
+    const auto inside = [&](std::uint64_t mask) {
+      const auto k = v.key() & mask;
+      return (min.key() & mask) <= k && k <= (max.key() & mask);
+    };
+    return inside(morton::x_mask) && inside(morton::y_mask) && inside(morton::z_mask);
+  }
+
+  //! The first voxel of the box in Morton order.
+  constexpr auto lower() const noexcept -> voxel { return min; }
+
+  //! The last voxel of the box in Morton order.
+  constexpr auto upper() const noexcept -> voxel { return max; }
+
+  //! The first voxel of the box after `v` in Morton order, for `v` between the corners and outside the box.
+  constexpr auto next(const voxel& v) const noexcept -> voxel
+  {
+    return voxel::from_key(morton::next_in_box(v.key(), min.key(), max.key()));
+  }
+};
+
+//! \private
+template <> struct ordered_book<voxel> : std::true_type
+{
+};
+
+} // namespace uat
+
+template <> struct std::hash<uat::voxel>
+{
+  auto operator()(const uat::voxel& v) const noexcept -> std::size_t { return std::hash<std::uint64_t>{}(v.key()); }
+};
+
+#endif // UAT_VOXEL_HPP
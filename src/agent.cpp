@@ -1,8 +1,41 @@
 #include <uat/agent.hpp>
 
+#include <algorithm>
+
 namespace uat
 {
 
+auto market_stats_t::add(value_t price) -> void
+{
+  ++count;
+  const auto delta = price - mean;
+  mean += delta / static_cast<value_t>(count);
+  m2 += delta * (price - mean);
+  last = price;
+  min = std::min(min, price);
+  max = std::max(max, price);
+}
+
+auto market_stats_t::merge(const market_stats_t& other) -> void
+{
+  if (other.count == 0)
+    return;
+  if (count == 0) {
+    *this = other;
+    return;
+  }
+
+  // Chan et al.'s pairwise update of the mean and the sum of squared deviations.
+  const auto n = static_cast<value_t>(count), m = static_cast<value_t>(other.count);
+  const auto delta = other.mean - mean;
+  mean += delta * m / (n + m);
+  m2 += other.m2 + delta * delta * n * m / (n + m);
+  count += other.count;
+  last = other.last;
+  min = std::min(min, other.min);
+  max = std::max(max, other.max);
+}
+
 auto any_agent::bid_phase(uint_t t, bid_fn b, permit_public_status_fn s, int seed) -> void
 {
   interface_->bid_phase(t, std::move(b), std::move(s), seed);
@@ -19,4 +52,6 @@ auto any_agent::on_sold(region_view s, uint_t t, value_t v) -> void { interface_
 
 auto any_agent::stop(uint_t t, int seed) -> bool { return interface_->stop(t, seed); }
 
+auto any_agent::serialize(std::ostream& os) const -> void { interface_->serialize(os); }
+
 } // namespace uat
@@ -0,0 +1,85 @@
+#include <uat/coroutine.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace uat
+{
+
+namespace
+{
+
+constexpr std::size_t granularity = 64;
+constexpr std::size_t size_classes = 32; // Frames up to 2 KiB are pooled.
+constexpr std::size_t chunk_size = 64 * 1024;
+
+struct free_block
+{
+  free_block* next;
+};
+
+struct frame_pool_state
+{
+  std::mutex mutex;
+  std::array<free_block*, size_classes> free = {};
+  std::vector<std::unique_ptr<std::byte[]>> chunks;
+  std::size_t reserved = 0;
+};
+
+auto pool_state() -> frame_pool_state&
+{
+  static frame_pool_state state;
+  return state;
+}
+
+auto size_class(std::size_t size) -> std::size_t { return (size + granularity - 1) / granularity - 1; }
+
+} // namespace
+
+auto frame_pool::allocate(std::size_t size) -> void*
+{
+  const auto cls = size_class(size);
+  if (cls >= size_classes)
+    return ::operator new(size);
+
+  auto& state = pool_state();
+  std::lock_guard lock(state.mutex);
+
+  if (!state.free[cls]) {
+    // Carve a new chunk into blocks of this class and thread them into the free list.
+    const auto block_size = (cls + 1) * granularity;
+    const auto count = std::max<std::size_t>(chunk_size / block_size, 1);
+    auto& chunk = state.chunks.emplace_back(new std::byte[count * block_size]);
+    state.reserved += count * block_size;
+    for (std::size_t i = count; i-- > 0;)
+      state.free[cls] = ::new (chunk.get() + i * block_size) free_block{state.free[cls]};
+  }
+
+  auto* block = state.free[cls];
+  state.free[cls] = block->next;
+  return block;
+}
+
+auto frame_pool::deallocate(void* ptr, std::size_t size) noexcept -> void
+{
+  const auto cls = size_class(size);
+  if (cls >= size_classes)
+    return ::operator delete(ptr, size);
+
+  auto& state = pool_state();
+  std::lock_guard lock(state.mutex);
+  state.free[cls] = ::new (ptr) free_block{state.free[cls]};
+}
+
+auto frame_pool::reserved() noexcept -> std::size_t
+{
+  auto& state = pool_state();
+  std::lock_guard lock(state.mutex);
+  return state.reserved;
+}
+
+} // namespace uat
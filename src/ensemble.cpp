@@ -0,0 +1,19 @@
+#include <uat/ensemble.hpp>
+
+#include <random>
+
+namespace uat
+{
+
+auto ensemble_seeds(uint_t runs, std::optional<uint_t> seed) -> std::vector<uint_t>
+{
+  std::mt19937 rnd(seed ? *seed : std::random_device{}());
+
+  std::vector<uint_t> seeds;
+  seeds.reserve(runs);
+  while (seeds.size() < runs)
+    seeds.push_back(rnd());
+  return seeds;
+}
+
+} // namespace uat
@@ -0,0 +1,126 @@
+#include <uat/scenario.hpp>
+
+#include <algorithm>
+
+namespace uat::scenario
+{
+
+route_agent::route_agent(std::vector<cell> route, value_t valuation, bool resells, uint_t deadline, uint_t search_window,
+                         bool bundles)
+  : route_(std::move(route)), valuation_(valuation), resells_(resells), deadline_(deadline), search_window_(search_window),
+    bundles_(bundles)
+{
+  owned_.reserve(route_.size());
+}
+
+auto route_agent::bid_phase(uint_t time, bid_fn bid, permit_public_status_fn status, int) -> void
+{
+  const auto available = [&](uint_t departure) {
+    for (uint_t i = 0; i < route_.size(); ++i)
+      if (!std::holds_alternative<permit_public_status::available>(status(route_[i], departure + i)))
+        return false;
+    return true;
+  };
+
+  for (auto departure = time + 1; departure <= time + search_window_; ++departure) {
+    if (!available(departure))
+      continue;
+    const auto value = valuation_ / static_cast<value_t>(route_.size());
+    if (bundles_) {
+      std::vector<bundle_item_t> items;
+      items.reserve(route_.size());
+      for (uint_t i = 0; i < route_.size(); ++i)
+        items.push_back({route_[i], departure + i, value});
+      bid.bundle(items);
+    } else {
+      for (uint_t i = 0; i < route_.size(); ++i)
+        bid(route_[i], departure + i, value);
+    }
+    return;
+  }
+}
+
+auto route_agent::ask_phase(uint_t, ask_fn ask, permit_public_status_fn, int) -> void
+{
+  if (owned_.size() == route_.size()) {
+    complete_ = true;
+    return;
+  }
+
+  if (resells_)
+    for (const auto& [location, time] : owned_)
+      ask(location, time, 0.0);
+  owned_.clear();
+}
+
+auto route_agent::on_bought(const cell& region, uint_t time, value_t) -> void { owned_.emplace_back(region, time); }
+
+auto route_agent::on_sold(const cell&, uint_t, value_t) -> void {}
+
+auto route_agent::stop(uint_t time, int) -> bool { return complete_ || time >= deadline_; }
+
+auto random_route(const scenario_opts_t& opts, uint_t length, std::mt19937& rnd) -> std::vector<cell>
+{
+  const auto coordinate = [&](std::uint32_t size) { return std::uniform_int_distribution<std::uint32_t>(0, size - 1)(rnd); };
+
+  std::vector<cell> route;
+  route.reserve(length);
+  route.push_back({coordinate(opts.width), coordinate(opts.depth), coordinate(opts.height)});
+
+  // Random walk to neighboring cells (including staying in place, i.e., hovering).
+  std::uniform_int_distribution<int> step(0, 6);
+  while (route.size() < length) {
+    auto next = route.back();
+    switch (step(rnd)) {
+    case 0:
+      next.x = next.x + 1 < opts.width ? next.x + 1 : next.x;
+      break;
+    case 1:
+      next.x = next.x > 0 ? next.x - 1 : next.x;
+      break;
+    case 2:
+      next.y = next.y + 1 < opts.depth ? next.y + 1 : next.y;
+      break;
+    case 3:
+      next.y = next.y > 0 ? next.y - 1 : next.y;
+      break;
+    case 4:
+      next.z = next.z + 1 < opts.height ? next.z + 1 : next.z;
+      break;
+    case 5:
+      next.z = next.z > 0 ? next.z - 1 : next.z;
+      break;
+    default:
+      break;
+    }
+    route.push_back(next);
+  }
+
+  return route;
+}
+
+auto make_factory(scenario_opts_t opts) -> factory_t
+{
+  return [opts](uint_t time, int seed) -> std::vector<any_agent> {
+    if (time >= opts.arrival_steps)
+      return {};
+
+    std::mt19937 rnd(seed);
+    const auto arrivals = std::poisson_distribution<uint_t>(opts.arrival_rate)(rnd);
+
+    std::uniform_int_distribution<uint_t> length(opts.min_route_length, std::max(opts.min_route_length, opts.max_route_length));
+    std::lognormal_distribution<value_t> valuation(opts.valuation_mu, opts.valuation_sigma);
+    std::bernoulli_distribution resells(opts.resale_probability);
+
+    std::vector<any_agent> agents;
+    agents.reserve(arrivals);
+    while (agents.size() < arrivals) {
+      auto route = random_route(opts, length(rnd), rnd);
+      agents.push_back(
+        route_agent(std::move(route), valuation(rnd), resells(rnd), time + opts.patience, opts.search_window, opts.bundle_bids));
+    }
+    return agents;
+  };
+}
+
+} // namespace uat::scenario
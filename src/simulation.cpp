@@ -5,6 +5,7 @@
 #include <deque>
 #include <functional>
 #include <limits>
+#include <sstream>
 #include <stdexcept>
 #include <unordered_map>
 #include <variant>
@@ -12,6 +13,8 @@
 namespace uat
 {
 
+agents_private_status_t::agents_private_status_t(std::pmr::memory_resource* resource) : agents_(resource), active_(resource) {}
+
 auto agents_private_status_t::status(id_t id) const -> agent_private_status_t { throw std::runtime_error{"not implemented yet"}; }
 
 auto agents_private_status_t::active_count() const -> uint_t { return active_.size(); }
@@ -24,10 +27,22 @@ void agents_private_status_t::insert(any_agent a)
   agents_.push_back(std::move(a));
 }
 
-void agents_private_status_t::update_active(std::vector<id_t> new_agents)
+void agents_private_status_t::reserve(uint_t n) { active_.reserve(n); }
+
+void agents_private_status_t::remove_active(std::span<const std::size_t> positions)
 {
-  assert(std::is_sorted(new_agents.begin(), new_agents.end()));
-  active_ = std::move(new_agents);
+  assert(std::is_sorted(positions.begin(), positions.end()));
+  if (positions.empty())
+    return;
+
+  // Stable compaction: only the ids after the first removed agent move, one run at a time.
+  auto out = active_.begin() + static_cast<std::ptrdiff_t>(positions.front());
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    const auto first = active_.begin() + static_cast<std::ptrdiff_t>(positions[i] + 1);
+    const auto last = i + 1 < positions.size() ? active_.begin() + static_cast<std::ptrdiff_t>(positions[i + 1]) : active_.end();
+    out = std::copy(first, last, out);
+  }
+  active_.erase(out, active_.end());
   if (active_.size() == 0)
     return;
 
@@ -45,4 +60,164 @@ auto agents_private_status_t::at(id_t id) -> any_agent&
   return agents_[id - first_id_];
 }
 
+void agents_private_status_t::serialize(std::ostream& os) const
+{
+  write_binary(os, first_id_);
+
+  // Each agent is length-prefixed so that a deserializer cannot read past its own state.
+  std::ostringstream buffer;
+  write_binary(os, agents_.size());
+  for (const auto& agent : agents_) {
+    buffer.str({});
+    agent.serialize(buffer);
+    write_string(os, buffer.view());
+  }
+
+  write_binary(os, active_.size());
+  os.write(reinterpret_cast<const char*>(active_.data()), static_cast<std::streamsize>(active_.size() * sizeof(id_t)));
+}
+
+void agents_private_status_t::deserialize(std::istream& is, const agent_deserializer_t& deserializer)
+{
+  if (!deserializer)
+    throw std::invalid_argument{"an agent deserializer is required to resume from a checkpoint"};
+
+  first_id_ = read_binary<uint_t>(is);
+
+  agents_.clear();
+  const auto count = read_binary<std::size_t>(is);
+  for (std::size_t i = 0; i < count; ++i) {
+    std::istringstream buffer(read_string(is));
+    agents_.push_back(deserializer(buffer));
+  }
+
+  active_.resize(read_binary<std::size_t>(is));
+  is.read(reinterpret_cast<char*>(active_.data()), static_cast<std::streamsize>(active_.size() * sizeof(id_t)));
+  if (!is)
+    throw std::runtime_error{"unexpected end of binary stream"};
+}
+
+auto write_permit_status(std::ostream& os, const permit_private_status_t& status) -> void
+{
+  write_binary(os, static_cast<std::uint8_t>(status.current.index()));
+  std::visit([&](const auto& current) { write_binary(os, current); }, status.current);
+
+  write_binary(os, status.history.size());
+  os.write(reinterpret_cast<const char*>(status.history.data()),
+           static_cast<std::streamsize>(status.history.size() * sizeof(trade_value_t)));
+}
+
+auto read_permit_status(std::istream& is) -> permit_private_status_t
+{
+  using namespace permit_private_status;
+
+  permit_private_status_t status;
+  switch (read_binary<std::uint8_t>(is)) {
+  case 0:
+    status.current = read_binary<on_sale>(is);
+    break;
+  case 1:
+    status.current = read_binary<in_use>(is);
+    break;
+  case 2:
+    status.current = read_binary<out_of_limits>(is);
+    break;
+  default:
+    throw std::runtime_error{"invalid permit status in binary stream"};
+  }
+
+  status.history.resize(read_binary<std::size_t>(is));
+  is.read(reinterpret_cast<char*>(status.history.data()),
+          static_cast<std::streamsize>(status.history.size() * sizeof(trade_value_t)));
+  if (!is)
+    throw std::runtime_error{"unexpected end of binary stream"};
+
+  for (const auto& trade : status.history)
+    status.market.add(trade.highest_bid);
+
+  return status;
+}
+
+stop_condition_t::stop_condition_t(const stop_criterion_t& criterion)
+  : criterion_(criterion), wall_start_(std::chrono::steady_clock::now()), cpu_start_(std::clock())
+{
+  using namespace stop_criterion;
+  const auto add_children = [&](const std::vector<stop_criterion_t>& criteria) {
+    children_.reserve(criteria.size());
+    for (const auto& c : criteria)
+      children_.emplace_back(c);
+  };
+  std::visit(cool::compose{[&](const any_of_t& c) { add_children(c.criteria); }, [&](const all_of_t& c) { add_children(c.criteria); },
+                           [&](const trade_volume_below_t& c) { window_.assign(std::max<uint_t>(c.window, 1), 0); },
+                           [](const auto&) {}},
+             criterion_);
+}
+
+auto stop_condition_t::record_step(uint_t trades) -> void
+{
+  quiet_steps_ = trades == 0 ? quiet_steps_ + 1 : 0;
+
+  if (!window_.empty()) {
+    window_sum_ = window_sum_ - window_[window_pos_] + trades;
+    window_[window_pos_] = trades;
+    window_pos_ = (window_pos_ + 1) % window_.size();
+  }
+  ++recorded_steps_;
+
+  for (auto& child : children_)
+    child.record_step(trades);
+}
+
+auto stop_condition_t::satisfied(uint_t time, uint_t active_agents) const -> bool
+{
+  using namespace stop_criterion;
+  return std::visit(
+    cool::compose{
+      [&](no_agents_t) { return active_agents == 0; },
+      [&](time_threshold_t c) { return time > c.t; },
+      [&](no_trades_t c) { return quiet_steps_ >= c.steps; },
+      // The window is only meaningful once it is full.
+      [&](trade_volume_below_t c) { return recorded_steps_ >= window_.size() && window_sum_ < c.threshold; },
+      [&](wall_clock_budget_t c) { return std::chrono::steady_clock::now() - wall_start_ >= c.budget; },
+      [&](cpu_budget_t c) {
+        const auto elapsed = std::chrono::duration<double>(static_cast<double>(std::clock() - cpu_start_) / CLOCKS_PER_SEC);
+        return elapsed >= c.budget;
+      },
+      [&](const any_of_t&) {
+        return std::any_of(children_.begin(), children_.end(), [&](const auto& c) { return c.satisfied(time, active_agents); });
+      },
+      [&](const all_of_t&) {
+        return std::all_of(children_.begin(), children_.end(), [&](const auto& c) { return c.satisfied(time, active_agents); });
+      }},
+    criterion_);
+}
+
+auto stop_condition_t::serialize(std::ostream& os) const -> void
+{
+  // Wall-clock and CPU budgets are not saved: they restart when a simulation is resumed.
+  write_binary(os, quiet_steps_);
+  write_binary(os, window_pos_);
+  write_binary(os, window_sum_);
+  write_binary(os, recorded_steps_);
+  os.write(reinterpret_cast<const char*>(window_.data()), static_cast<std::streamsize>(window_.size() * sizeof(uint_t)));
+  for (const auto& child : children_)
+    child.serialize(os);
+}
+
+auto stop_condition_t::deserialize(std::istream& is) -> void
+{
+  quiet_steps_ = read_binary<uint_t>(is);
+  window_pos_ = read_binary<uint_t>(is);
+  window_sum_ = read_binary<uint_t>(is);
+  recorded_steps_ = read_binary<uint_t>(is);
+  is.read(reinterpret_cast<char*>(window_.data()), static_cast<std::streamsize>(window_.size() * sizeof(uint_t)));
+  if (!is)
+    throw std::runtime_error{"unexpected end of binary stream"};
+  for (auto& child : children_)
+    child.deserialize(is);
+
+  wall_start_ = std::chrono::steady_clock::now();
+  cpu_start_ = std::clock();
+}
+
 } // namespace uat
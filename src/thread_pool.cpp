@@ -0,0 +1,134 @@
+#include <uat/thread_pool.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace uat
+{
+
+namespace
+{
+
+thread_local const thread_pool* current_pool = nullptr;
+thread_local std::size_t current_worker = thread_pool::no_worker;
+
+} // namespace
+
+thread_pool::thread_pool(std::size_t threads)
+{
+  threads = std::max<std::size_t>(threads, 1);
+
+  queues_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i)
+    queues_.push_back(std::make_unique<worker_queue>());
+
+  workers_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i)
+    workers_.emplace_back([this, i] { work(i); });
+}
+
+thread_pool::~thread_pool()
+{
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_)
+    worker.join();
+}
+
+auto thread_pool::size() const noexcept -> std::size_t { return workers_.size(); }
+
+auto thread_pool::submit(std::function<void()> task) -> void
+{
+  std::size_t target;
+  if (current_pool == this) {
+    target = current_worker;
+  } else {
+    std::lock_guard lock(mutex_);
+    target = next_queue_++ % queues_.size();
+  }
+
+  {
+    std::lock_guard lock(queues_[target]->mutex);
+    queues_[target]->tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    ++queued_;
+    ++pending_;
+  }
+  wake_.notify_one();
+}
+
+auto thread_pool::wait() -> void
+{
+  std::unique_lock lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+  if (error_)
+    std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+auto thread_pool::worker_index() noexcept -> std::size_t { return current_worker; }
+
+auto thread_pool::try_pop(std::size_t self, std::function<void()>& task) -> bool
+{
+  {
+    auto& own = *queues_[self];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+
+  for (std::size_t i = 1; i < queues_.size(); ++i) {
+    auto& victim = *queues_[(self + i) % queues_.size()];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+auto thread_pool::work(std::size_t self) -> void
+{
+  current_pool = this;
+  current_worker = self;
+
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+      if (queued_ == 0)
+        return;
+      // Tasks are enqueued before being counted, so a reservation guarantees one exists.
+      --queued_;
+    }
+
+    std::function<void()> task;
+    while (!try_pop(self, task))
+      std::this_thread::yield();
+
+    try {
+      task();
+    } catch (...) {
+      std::lock_guard lock(mutex_);
+      if (!error_)
+        error_ = std::current_exception();
+    }
+
+    std::lock_guard lock(mutex_);
+    if (--pending_ == 0)
+      done_.notify_all();
+  }
+}
+
+} // namespace uat
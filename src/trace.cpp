@@ -0,0 +1,114 @@
+#include <uat/trace.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace uat
+{
+
+namespace
+{
+
+std::atomic<std::uint64_t> next_tracer_id = 1;
+
+constexpr std::size_t chunk_size = 4096;
+
+constexpr std::size_t cached_tracers = 4; // Tracers whose buffers each thread finds without locking.
+
+auto write_microseconds(std::ostream& os, std::int64_t ns) -> void
+{
+  const auto fraction = ns % 1000;
+  os << ns / 1000 << '.' << fraction / 100 << fraction / 10 % 10 << fraction % 10;
+}
+
+} // namespace
+
+//! \private
+//! Events of a single thread, stored in fixed-size chunks so that recording never moves them.
+struct tracer::buffer
+{
+  std::thread::id owner;
+  std::size_t thread;
+  std::vector<std::unique_ptr<std::array<event, chunk_size>>> chunks;
+  std::size_t size = 0;
+};
+
+tracer::tracer(bool agent_events)
+  : agent_events_(agent_events), id_(next_tracer_id++), origin_(std::chrono::steady_clock::now())
+{}
+
+tracer::~tracer() = default;
+
+auto tracer::local_buffer() -> buffer&
+{
+  // Tracers are identified by a unique id rather than their address, which may be reused, so
+  // entries of destroyed tracers never match.
+  struct cache_entry
+  {
+    std::uint64_t id = 0;
+    buffer* buf = nullptr;
+  };
+  thread_local std::array<cache_entry, cached_tracers> cache;
+  thread_local std::size_t next_entry = 0;
+
+  for (const auto& entry : cache)
+    if (entry.id == id_)
+      return *entry.buf;
+
+  // The buffer of this thread may have been evicted from the cache by other tracers.
+  std::lock_guard lock(mutex_);
+  const auto owner = std::this_thread::get_id();
+  auto it = std::ranges::find_if(buffers_, [&](const auto& b) { return b->owner == owner; });
+  if (it == buffers_.end())
+    it = buffers_.insert(it, std::make_unique<buffer>(buffer{owner, buffers_.size(), {}}));
+  cache[next_entry] = {id_, it->get()};
+  next_entry = (next_entry + 1) % cache.size();
+  return **it;
+}
+
+auto tracer::record(const event& e) -> void
+{
+  auto& b = local_buffer();
+  if (b.size == b.chunks.size() * chunk_size)
+    b.chunks.push_back(std::make_unique<std::array<event, chunk_size>>());
+  (*b.chunks[b.size / chunk_size])[b.size % chunk_size] = e;
+  ++b.size;
+}
+
+auto tracer::write(std::ostream& os) const -> void
+{
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  bool first = true;
+  for (const auto& b : buffers_) {
+    for (std::size_t i = 0; i < b->size; ++i) {
+      const auto& e = (*b->chunks[i / chunk_size])[i % chunk_size];
+      os << (first ? "\n" : ",\n") << "{\"name\":\"" << e.name << "\",\"cat\":\"" << (e.agent == no_agent ? "phase" : "agent")
+         << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << b->thread << ",\"ts\":";
+      write_microseconds(os, e.begin);
+      os << ",\"dur\":";
+      write_microseconds(os, e.end - e.begin);
+      os << ",\"args\":{\"step\":" << e.step;
+      if (e.agent != no_agent)
+        os << ",\"agent\":" << e.agent;
+      os << "}}";
+      first = false;
+    }
+  }
+
+  os << "\n]}\n";
+}
+
+auto tracer::save(const std::filesystem::path& path) const -> void
+{
+  std::ofstream os(path);
+  write(os);
+  if (!os.flush())
+    throw std::runtime_error{"could not write trace file"};
+}
+
+} // namespace uat
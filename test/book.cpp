@@ -0,0 +1,102 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using fixture::cell;
+using fixture::dense_cell;
+
+static_assert(std::same_as<uat::book_bucket_t<cell>, uat::hashed_bucket<cell>>);
+static_assert(std::same_as<uat::book_bucket_t<dense_cell>, uat::dense_bucket<dense_cell>>);
+
+namespace
+{
+
+using entry_t = std::tuple<uat::uint_t, std::uint32_t, uat::uint_t, std::size_t, std::size_t>;
+
+//! Permits stored in the book at the beginning of each step, as (step, region, time, status, history) tuples.
+template <typename R> auto snapshot(std::vector<entry_t>& entries) -> uat::simulation_callback_t
+{
+  return [&entries](uat::uint_t now, const uat::agents_private_status_t&, uat::book_view book) {
+    const auto first = entries.size();
+    book.for_each([&](uat::region_view region, uat::uint_t t, const uat::permit_private_status_t& status) {
+      entries.emplace_back(now, region.downcast<R>().id, t, status.current.index(), status.history.size());
+    });
+    std::sort(entries.begin() + static_cast<std::ptrdiff_t>(first), entries.end()); // Buckets differ in order.
+  };
+}
+
+template <typename R> auto run(std::string& trades, std::vector<entry_t>& entries) -> void
+{
+  uat::simulate<R>({
+    .factory = fixture::trader_factory<R>(),
+    .trade_callback = fixture::record_trades<R>(trades),
+    .simulation_callback = snapshot<R>(entries),
+    .seed = 8,
+  });
+}
+
+} // namespace
+
+TEST_CASE("dense and hashed books trade identically", "[book]")
+{
+  std::string hashed_trades, dense_trades;
+  std::vector<entry_t> hashed_book, dense_book;
+  run<cell>(hashed_trades, hashed_book);
+  run<dense_cell>(dense_trades, dense_book);
+
+  CHECK(dense_trades == hashed_trades);
+  CHECK(dense_book == hashed_book);
+  CHECK(!hashed_trades.empty());
+}
+
+TEST_CASE("dense buckets are reset when cleared", "[book]")
+{
+  uat::dense_bucket<dense_cell> bucket;
+  CHECK(bucket.find(dense_cell{3}) == nullptr);
+
+  auto [status, inserted] = bucket.get(dense_cell{3});
+  CHECK(inserted);
+  status.current = uat::permit_private_status::in_use{7};
+  status.history.push_back({1.0, 2.0});
+  status.market.add(2.0);
+  CHECK(!bucket.get(dense_cell{3}).second);
+  CHECK(bucket.size() == 1);
+
+  bucket.clear();
+  CHECK(bucket.size() == 0);
+  CHECK(bucket.find(dense_cell{3}) == nullptr);
+  const auto& reused = bucket.get(dense_cell{3}).first;
+  CHECK(std::holds_alternative<uat::permit_private_status::on_sale>(reused.current));
+  CHECK(std::get<uat::permit_private_status::on_sale>(reused.current).owner == uat::no_owner);
+  CHECK(reused.history.empty());
+  CHECK(reused.market.count == 0);
+}
+
+TEST_CASE("permit statistics match the history after buckets are recycled", "[book]")
+{
+  const auto check = [](auto region) {
+    using R = decltype(region);
+    uat::uint_t steps = 0, traded = 0;
+    uat::simulate<R>({
+      .factory = fixture::trader_factory<R>(),
+      .simulation_callback =
+        [&](uat::uint_t, const uat::agents_private_status_t&, uat::book_view book) {
+          book.for_each([&](uat::region_view, uat::uint_t, const uat::permit_private_status_t& status) {
+            CHECK(status.market.count == status.history.size());
+            traded += !status.history.empty();
+          });
+          ++steps;
+        },
+      .seed = 8,
+    });
+    CHECK(steps > 40); // Far more steps than buckets in the book, so buckets are reused.
+    CHECK(traded > 0);
+  };
+  check(cell{});
+  check(dense_cell{});
+}
@@ -0,0 +1,184 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using fixture::cell;
+
+namespace
+{
+
+//! Bids of an agent: a bundle of all items, or a single bid for its only item.
+struct order_t
+{
+  std::vector<std::tuple<std::uint32_t, uat::uint_t, uat::value_t>> items;
+  bool bundle = true;
+};
+
+//! What happened to the orders of an agent.
+struct outcome_t
+{
+  std::vector<bool> accepted;
+  std::map<std::pair<std::uint32_t, uat::uint_t>, uat::value_t> bought;
+};
+
+//! Agent that places its orders in its first bid phase and leaves.
+class bidder : public uat::agent<cell>
+{
+public:
+  bidder(std::vector<order_t> orders, outcome_t& outcome) : orders_(std::move(orders)), outcome_(&outcome) {}
+
+  auto bid_phase(uat::uint_t, uat::bid_fn bid, uat::permit_public_status_fn, int) -> void override
+  {
+    for (const auto& order : orders_) {
+      if (!order.bundle) {
+        const auto& [id, t, value] = order.items.front();
+        outcome_->accepted.push_back(bid(cell{id}, t, value));
+        continue;
+      }
+      std::vector<cell> regions;
+      for (const auto& [id, t, value] : order.items)
+        regions.push_back(cell{id});
+      std::vector<uat::bundle_item_t> items;
+      for (std::size_t i = 0; i < regions.size(); ++i)
+        items.push_back({regions[i], std::get<1>(order.items[i]), std::get<2>(order.items[i])});
+      outcome_->accepted.push_back(bid.bundle(items));
+    }
+  }
+
+  auto on_bought(const cell& region, uat::uint_t time, uat::value_t value) -> void override
+  {
+    outcome_->bought.emplace(std::pair{region.id, time}, value);
+  }
+
+  auto stop(uat::uint_t, int) -> bool override { return true; }
+
+private:
+  std::vector<order_t> orders_;
+  outcome_t* outcome_;
+};
+
+//! Runs the simulation while there are agents to enter; `arrivals[t]` enter at step `t`.
+auto run(const std::vector<std::vector<bidder>>& arrivals) -> uat::simulation<cell>
+{
+  uat::simulation<cell> sim({
+    .factory = [arrivals](uat::uint_t t, int) {
+      std::vector<uat::any_agent> agents;
+      if (t < arrivals.size())
+        for (const auto& agent : arrivals[t])
+          agents.push_back(agent);
+      return agents;
+    },
+  });
+  while (sim.time() < arrivals.size())
+    sim.step();
+  return sim;
+}
+
+auto owner(const uat::simulation<cell>& sim, std::uint32_t id, uat::uint_t t) -> uat::uint_t
+{
+  const auto status = sim.status(cell{id}, t);
+  const auto* in_use = std::get_if<uat::permit_private_status::in_use>(&status.current);
+  return in_use ? in_use->owner : uat::no_owner;
+}
+
+} // namespace
+
+TEST_CASE("uncontested bundles win every permit", "[bundle]")
+{
+  outcome_t a;
+  const auto sim = run({{bidder({{{{0, 2, 1.0}, {1, 3, 2.0}, {2, 4, 3.0}}}}, a)}});
+
+  CHECK(a.accepted == std::vector{true});
+  CHECK(a.bought == decltype(a.bought){{{0, 2}, 1.0}, {{1, 3}, 2.0}, {{2, 4}, 3.0}});
+  CHECK(owner(sim, 0, 2) == 0);
+  CHECK(owner(sim, 1, 3) == 0);
+  CHECK(owner(sim, 2, 4) == 0);
+}
+
+TEST_CASE("bundles with an unavailable permit win none of them", "[bundle]")
+{
+  outcome_t a, b;
+  const auto sim = run({
+    {bidder({{{{0, 3, 1.0}}, false}}, a)},
+    {bidder(
+      {
+        {{{0, 3, 5.0}, {1, 3, 5.0}}}, // The first permit is in use.
+        {{{1, 0, 5.0}, {2, 3, 5.0}}}, // The first permit is in the past.
+        {},                           // Empty bundles are rejected.
+      },
+      b)},
+  });
+
+  CHECK(a.bought.size() == 1);
+  CHECK(b.accepted == std::vector{false, false, false});
+  CHECK(b.bought.empty());
+  CHECK(owner(sim, 0, 3) == 0);
+  CHECK(owner(sim, 1, 3) == uat::no_owner);
+  CHECK(owner(sim, 2, 3) == uat::no_owner);
+  CHECK(sim.status(cell{1}, 3).history.empty());
+}
+
+TEST_CASE("bundles outbid on a single permit win none of them", "[bundle]")
+{
+  SECTION("a higher single bid takes the permit")
+  {
+    outcome_t a, b;
+    const auto sim = run({{bidder({{{{0, 2, 2.0}, {1, 2, 2.0}}}}, a), bidder({{{{1, 2, 3.0}}, false}}, b)}});
+
+    CHECK(a.accepted == std::vector{true}); // Accepted bundles may still lose.
+    CHECK(a.bought.empty());
+    CHECK(b.bought == decltype(b.bought){{{1, 2}, 3.0}});
+    CHECK(owner(sim, 0, 2) == uat::no_owner);
+    CHECK(owner(sim, 1, 2) == 1);
+  }
+
+  SECTION("a lower single bid loses the permit to the bundle")
+  {
+    outcome_t a, b;
+    const auto sim = run({{bidder({{{{1, 2, 1.0}}, false}}, b), bidder({{{{0, 2, 2.0}, {1, 2, 2.0}}}}, a)}});
+
+    CHECK(b.accepted == std::vector{true});
+    CHECK(b.bought.empty());
+    CHECK(a.bought == decltype(a.bought){{{0, 2}, 2.0}, {{1, 2}, 2.0}});
+    CHECK(owner(sim, 1, 2) == 1);
+  }
+
+  SECTION("an equal single bid keeps the permit")
+  {
+    outcome_t a, b;
+    const auto sim = run({{bidder({{{{1, 2, 2.0}}, false}}, b), bidder({{{{0, 2, 2.0}, {1, 2, 2.0}}}}, a)}});
+
+    CHECK(a.bought.empty());
+    CHECK(b.bought == decltype(b.bought){{{1, 2}, 2.0}});
+    CHECK(owner(sim, 0, 2) == uat::no_owner);
+  }
+}
+
+TEST_CASE("conflicting bundles are awarded by total value", "[bundle]")
+{
+  outcome_t a, b, c, d, e, f;
+  const auto sim = run({{
+    bidder({{{{0, 2, 1.0}, {1, 2, 1.0}}}}, a),             // Loses permit 1 to b, and so permit 0 too.
+    bidder({{{{1, 2, 1.5}, {2, 2, 1.5}}}}, b),             // Highest total.
+    bidder({{{{3, 2, 1.0}, {4, 2, 1.0}}}}, c),             // Does not conflict.
+    bidder({{{{5, 2, 1.0}, {6, 2, 1.0}}}}, d),             // Ties with e and comes first.
+    bidder({{{{6, 2, 1.0}, {7, 2, 1.0}}}}, e),             // Ties with d.
+    bidder({{{{8, 2, 1.0}, {8, 2, 1.0}, {9, 2, 1.0}}}}, f), // Conflicts with itself.
+  }});
+
+  CHECK(a.bought.empty());
+  CHECK(b.bought == decltype(b.bought){{{1, 2}, 1.5}, {{2, 2}, 1.5}});
+  CHECK(c.bought == decltype(c.bought){{{3, 2}, 1.0}, {{4, 2}, 1.0}});
+  CHECK(d.bought == decltype(d.bought){{{5, 2}, 1.0}, {{6, 2}, 1.0}});
+  CHECK(e.bought.empty());
+  CHECK(f.bought.empty());
+  for (const std::uint32_t id : {0, 7, 8, 9})
+    CHECK(owner(sim, id, 2) == uat::no_owner);
+  if constexpr (uat::metrics_enabled)
+    CHECK(sim.metrics().bundles_awarded == 3);
+}
@@ -0,0 +1,119 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+
+using fixture::cell;
+
+namespace
+{
+
+//! Signature of the simulation callback before the book view and the metrics were added.
+using baseline_callback_t = std::function<void(uat::uint_t, const uat::agents_private_status_t&, uat::permit_private_status_fn)>;
+
+//! Number of permits in use in the next steps, according to point lookups.
+auto count_in_use(uat::permit_private_status_fn status, uat::uint_t now) -> int
+{
+  int count = 0;
+  for (std::uint32_t id = 0; id < fixture::cells; ++id)
+    for (auto t = now; t < now + 5; ++t)
+      count += std::holds_alternative<uat::permit_private_status::in_use>(status(cell{id}, t).current);
+  return count;
+}
+
+} // namespace
+
+TEST_CASE("callbacks written against the baseline signature still work", "[callback]")
+{
+  std::map<uat::uint_t, int> from_lambda, from_function;
+
+  const auto lambda = [&](uat::uint_t t, const uat::agents_private_status_t&, uat::permit_private_status_fn status) {
+    from_lambda[t] = count_in_use(status, t);
+  };
+  const baseline_callback_t function = [&](uat::uint_t t, const uat::agents_private_status_t&, uat::permit_private_status_fn status) {
+    from_function[t] = count_in_use(status, t);
+  };
+
+  uat::simulation_opts_t<cell> opts{.factory = fixture::trader_factory<cell>(), .seed = 4};
+  opts.simulation_callback = lambda;
+  uat::simulate<cell>(opts);
+
+  opts.simulation_callback = function;
+  uat::simulate<cell>(opts);
+
+  CHECK(from_function == from_lambda);
+  CHECK(std::ranges::any_of(from_lambda, [](const auto& entry) { return entry.second > 0; }));
+}
+
+TEST_CASE("the book view visits the permits found by point lookups", "[callback]")
+{
+  uat::uint_t checked = 0;
+  uat::simulate<cell>({
+    .factory = fixture::trader_factory<cell>(),
+    .simulation_callback =
+      [&](uat::uint_t now, const uat::agents_private_status_t&, uat::book_view book, const uat::simulation_metrics_t&) {
+        std::map<std::tuple<std::uint32_t, uat::uint_t>, std::size_t> visited;
+        book.for_each([&](uat::region_view region, uat::uint_t t, const uat::permit_private_status_t& status) {
+          CHECK(t >= now);
+          const auto id = region.downcast<cell>().id;
+          CHECK(book(cell{id}, t).current.index() == status.current.index());
+          CHECK(book(cell{id}, t).history.size() == status.history.size());
+          visited.emplace(std::tuple{id, t}, status.history.size());
+        });
+
+        std::size_t in_range = 0;
+        book.for_each(now + 1, now + 3, [&](uat::region_view, uat::uint_t t, const uat::permit_private_status_t&) {
+          CHECK((t >= now + 1 && t < now + 3));
+          ++in_range;
+        });
+        CHECK(in_range == static_cast<std::size_t>(std::ranges::count_if(visited, [&](const auto& entry) {
+                const auto t = std::get<1>(entry.first);
+                return t >= now + 1 && t < now + 3;
+              })));
+        checked += visited.size();
+      },
+    .seed = 4,
+  });
+  CHECK(checked > 0);
+}
+
+TEST_CASE("callbacks receive the metrics of the previous step", "[callback]")
+{
+  uat::simulation_metrics_t previous;
+  uat::uint_t calls = 0, views = 0, trades = 0;
+
+  uat::simulation<cell> sim({
+    .factory = fixture::trader_factory<cell>(),
+    .simulation_callback =
+      [&](uat::uint_t, const uat::agents_private_status_t&, uat::book_view, const uat::simulation_metrics_t& metrics) {
+        CHECK(metrics.agents_created == previous.agents_created);
+        CHECK(metrics.agents_active == previous.agents_active);
+        CHECK(metrics.trades == previous.trades);
+        CHECK(metrics.book_entries == previous.book_entries);
+        trades += metrics.trades;
+        ++calls;
+      },
+    .seed = 4,
+  });
+  for (int i = 0; i < 30; ++i) {
+    sim.step();
+    previous = sim.metrics();
+  }
+  CHECK(calls == 30);
+  if constexpr (uat::metrics_enabled)
+    CHECK(trades > 0);
+
+  // Callbacks that ignore the metrics receive the view itself.
+  uat::simulate<cell>({
+    .factory = fixture::trader_factory<cell>(),
+    .simulation_callback = [&](uat::uint_t t, const uat::agents_private_status_t&, uat::book_view book) {
+      views += std::holds_alternative<uat::permit_private_status::out_of_limits>(book(cell{0}, t - 1).current);
+    },
+    .seed = 4,
+  });
+  CHECK(views > 0);
+}
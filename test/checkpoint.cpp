@@ -0,0 +1,84 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+
+using fixture::cell;
+
+namespace
+{
+
+auto options(std::string& trades) -> uat::simulation_opts_t<cell>
+{
+  return {.factory = fixture::trader_factory<cell>(),
+          .trade_callback = fixture::record_trades<cell>(trades),
+          .seed = 3,
+          .agent_deserializer = &fixture::trader<cell>::deserialize};
+}
+
+} // namespace
+
+TEST_CASE("resuming from a saved state reproduces the rest of the run", "[checkpoint]")
+{
+  std::string before, after;
+
+  uat::simulation<cell> sim(options(before));
+  sim.run_until(20);
+  std::stringstream state;
+  sim.save(state);
+
+  uat::simulation<cell> rest(options(after));
+  rest.load(state);
+  REQUIRE(rest.time() == 20);
+  REQUIRE(rest.agents().active_count() == sim.agents().active_count());
+
+  std::string expected;
+  {
+    uat::simulation<cell> full(options(expected));
+    full.run();
+  }
+  rest.run();
+  CHECK(before + after == expected);
+  CHECK(!after.empty());
+}
+
+TEST_CASE("checkpoint files resume the simulation", "[checkpoint]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "uat_checkpoint_test.bin";
+  const auto saved = std::filesystem::temp_directory_path() / "uat_checkpoint_test_25.bin";
+  std::string expected, resumed;
+
+  auto opts = options(expected);
+  opts.checkpoint = uat::checkpoint_opts_t{path, 25};
+  uat::simulation<cell> sim(opts);
+  sim.run_until(25);
+  REQUIRE(std::filesystem::exists(path));
+  std::filesystem::copy_file(path, saved, std::filesystem::copy_options::overwrite_existing); // Later checkpoints replace it.
+  const auto at_checkpoint = expected.size();
+  sim.run();
+
+  auto resume = options(resumed);
+  resume.resume_from = saved;
+  uat::simulation<cell> restored(resume);
+  CHECK(restored.time() == 25);
+  restored.run();
+  CHECK(resumed == expected.substr(at_checkpoint));
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(saved);
+}
+
+TEST_CASE("invalid checkpoints are rejected", "[checkpoint]")
+{
+  std::string trades;
+  std::stringstream garbage("not a checkpoint");
+  uat::simulation<cell> sim(options(trades));
+  CHECK_THROWS_AS(sim.load(garbage), std::runtime_error);
+
+  auto opts = options(trades);
+  opts.resume_from = std::filesystem::temp_directory_path() / "uat_checkpoint_test_missing.bin";
+  CHECK_THROWS_AS(uat::simulation<cell>(opts), std::runtime_error);
+}
@@ -0,0 +1,80 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <uat/coroutine.hpp>
+
+#include <string>
+
+using fixture::cell;
+
+namespace
+{
+
+// The random engines live outside of the coroutine, so that its frame is small enough to be pooled.
+auto place_bids(const uat::bid_context_t<cell>& bid, std::uint32_t home) -> void
+{
+  std::mt19937 rng(static_cast<unsigned>(bid.seed));
+  for (int i = 0; i < 3; ++i) {
+    const cell region{static_cast<std::uint32_t>((home + rng() % 5) % fixture::cells)};
+    const auto t = bid.time + 1 + rng() % 4;
+    if (std::holds_alternative<uat::permit_public_status::available>(bid.status(region, t)))
+      bid.bid(region, t, 0.5 + (rng() % 100) / 50.0);
+  }
+}
+
+auto place_asks(const uat::ask_context_t<cell>& ask) -> void
+{
+  std::mt19937 rng(static_cast<unsigned>(ask.seed));
+  for (const auto& permit : ask.bought)
+    if (rng() % 2)
+      ask.ask(permit.location, permit.time, 0.3);
+}
+
+//! Same behavior as `fixture::trader`, written as a coroutine.
+auto trader(std::uint32_t home, uat::uint_t last_step) -> uat::agent_task<cell>
+{
+  while (true) {
+    place_bids(co_await uat::next_bid, home);
+    const auto ask = co_await uat::next_ask;
+    place_asks(ask);
+    if (ask.time >= last_step)
+      co_return;
+  }
+}
+
+auto coroutine_factory() -> uat::factory_t
+{
+  return [](uat::uint_t t, int seed) {
+    std::vector<uat::any_agent> agents;
+    std::mt19937 rng(static_cast<unsigned>(seed));
+    if (t < 40)
+      for (int i = 0; i < 5; ++i) {
+        const auto home = static_cast<std::uint32_t>(rng() % fixture::cells);
+        agents.push_back(uat::coroutine_agent<cell>(trader(home, t + 5 + rng() % 10)));
+      }
+    return agents;
+  };
+}
+
+} // namespace
+
+TEST_CASE("coroutine agents trade like the equivalent class agents", "[coroutine]")
+{
+  std::string expected, trades;
+  uat::simulate<cell>({.factory = fixture::trader_factory<cell>(), .trade_callback = fixture::record_trades<cell>(expected), .seed = 9});
+  uat::simulate<cell>({.factory = coroutine_factory(), .trade_callback = fixture::record_trades<cell>(trades), .seed = 9});
+  CHECK(trades == expected);
+  CHECK(!trades.empty());
+}
+
+TEST_CASE("frames of finished agents are reused", "[coroutine]")
+{
+  uat::simulate<cell>({.factory = coroutine_factory(), .seed = 1});
+  const auto reserved = uat::frame_pool::reserved();
+  CHECK(reserved > 0);
+
+  uat::simulate<cell>({.factory = coroutine_factory(), .seed = 2});
+  uat::simulate<cell>({.factory = coroutine_factory(), .seed = 3});
+  CHECK(uat::frame_pool::reserved() == reserved);
+}
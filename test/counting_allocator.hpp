@@ -0,0 +1,64 @@
+//! \file counting_allocator.hpp
+//! \brief Replaces the global allocator with one that counts allocations.
+//!
+//! The replacements are ordinary (non-inline) definitions of the global `operator new` and
+//! `operator delete`, so this header must be included by exactly one translation unit of an
+//! executable.  It is shared by the steady state test and the micro-benchmarks.
+
+#ifndef UAT_TEST_COUNTING_ALLOCATOR_HPP
+#define UAT_TEST_COUNTING_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace counting_allocator
+{
+
+inline std::atomic<std::uint64_t> count = 0;
+
+//! Number of calls to the global `operator new` so far.
+inline auto allocations() noexcept -> std::uint64_t { return count.load(std::memory_order_relaxed); }
+
+} // namespace counting_allocator
+
+// GCC sees these definitions where `delete` is inlined, and takes the `std::free` of memory from
+// `operator new` for a mismatch.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+auto operator new(std::size_t size) -> void*
+{
+  counting_allocator::count.fetch_add(1, std::memory_order_relaxed);
+  if (auto* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+auto operator delete(void* ptr) noexcept -> void { std::free(ptr); }
+
+auto operator delete(void* ptr, std::size_t) noexcept -> void { std::free(ptr); }
+
+// Memory resources (e.g., std::pmr::new_delete_resource) use the aligned overloads.
+auto operator new(std::size_t size, std::align_val_t alignment) -> void*
+{
+  counting_allocator::count.fetch_add(1, std::memory_order_relaxed);
+  const auto align = static_cast<std::size_t>(alignment);
+  if (auto* ptr = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+auto operator delete(void* ptr, std::align_val_t) noexcept -> void { std::free(ptr); }
+
+auto operator delete(void* ptr, std::size_t, std::align_val_t) noexcept -> void { std::free(ptr); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // UAT_TEST_COUNTING_ALLOCATOR_HPP
@@ -0,0 +1,104 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+
+//! Query that visits every permit.
+struct everything
+{
+  template <typename R> auto contains(const R&) const -> bool { return true; }
+};
+
+//! Fields of a private status that the tests compare.
+using entry_t = std::tuple<std::size_t, uat::uint_t, uat::value_t, uat::uint_t, std::size_t>;
+
+auto entry(const uat::permit_private_status_t& status) -> entry_t
+{
+  using namespace uat::permit_private_status;
+  const auto* sale = std::get_if<on_sale>(&status.current);
+  const auto* use = std::get_if<in_use>(&status.current);
+  return {status.current.index(), sale ? sale->owner : use ? use->owner : uat::no_owner, sale ? sale->min_value : 0.0,
+          sale ? sale->highest_bidder : uat::no_owner, status.history.size()};
+}
+
+//! Permits in the book, keyed by cell and time.
+using book_t = std::map<std::pair<std::uint32_t, uat::uint_t>, entry_t>;
+
+//! Every permit in the book, except those in their initial status.
+//!
+//! Agents looking up a permit may store it in the book without changing it, and such permits
+//! are reported like those that are not stored at all.
+template <typename R> auto snapshot(const uat::simulation<R>& sim) -> book_t
+{
+  const auto initial = entry(uat::permit_private_status_t{});
+  book_t book;
+  sim.query(everything{}, 0, std::numeric_limits<uat::uint_t>::max(),
+            [&](const R& region, uat::uint_t t, const uat::permit_private_status_t& status) {
+              if (entry(status) != initial)
+                book.emplace(std::pair{region.id, t}, entry(status));
+            });
+  return book;
+}
+
+template <typename R> auto check_deltas(uat::simulation_opts_t<R> opts) -> void
+{
+  std::vector<uat::permit_change_t<R>> changes;
+  std::vector<uat::id_t> added, stopped;
+  uat::uint_t delivered = 0;
+  opts.factory = fixture::trader_factory<R>();
+  opts.delta_callback = [&](const uat::step_changes_t<R>& step) {
+    changes.assign(step.permits.begin(), step.permits.end());
+    added.assign(step.agents_added.begin(), step.agents_added.end());
+    stopped.assign(step.agents_stopped.begin(), step.agents_stopped.end());
+    ++delivered;
+  };
+  opts.seed = 9;
+
+  uat::simulation<R> sim(std::move(opts));
+  book_t book;
+  std::set<uat::id_t> active;
+  std::size_t applied = 0;
+  while (!sim.finished()) {
+    const auto time = sim.time();
+    sim.step();
+    REQUIRE(delivered == time + 1);
+
+    // Expired permits leave the book; the others take the status they have now.
+    for (const auto& [kind, region, t] : changes) {
+      if (kind == uat::permit_change::expired) {
+        CHECK(t == time);
+        book.erase({region.id, t});
+      } else {
+        CHECK(t >= time);
+        book[{region.id, t}] = entry(sim.status(region, t));
+      }
+    }
+    CHECK(book == snapshot(sim));
+
+    for (const auto id : added)
+      CHECK(active.insert(id).second);
+    for (const auto id : stopped)
+      CHECK(active.erase(id) == 1);
+    const auto live = sim.agents().active();
+    CHECK(active == std::set<uat::id_t>(live.begin(), live.end()));
+    applied += changes.size();
+  }
+  CHECK(applied > 100);
+}
+
+} // namespace
+
+TEST_CASE("deltas applied to the previous book give the next book", "[delta]")
+{
+  check_deltas<fixture::cell>({});
+  check_deltas<fixture::dense_cell>({});
+}
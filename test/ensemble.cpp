@@ -0,0 +1,49 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <uat/ensemble.hpp>
+
+#include <string>
+
+using fixture::cell;
+
+namespace
+{
+
+auto setup(uat::uint_t, std::string& trades) -> uat::simulation_opts_t<cell>
+{
+  return {.factory = fixture::trader_factory<cell>(), .trade_callback = fixture::record_trades<cell>(trades)};
+}
+
+auto concatenate(std::string& all, std::string&& trades) -> void { all += trades + "--\n"; }
+
+auto run_ensemble(uat::thread_pool& pool) -> std::string
+{
+  return uat::simulate_ensemble<cell>(pool, {.runs = 12, .seed = 5}, setup, concatenate, std::string{});
+}
+
+} // namespace
+
+TEST_CASE("ensemble results do not depend on the number of workers", "[ensemble]")
+{
+  const auto sequential = uat::simulate_ensemble<cell>({.runs = 12, .seed = 5, .threads = 1}, setup, concatenate, std::string{});
+  const auto parallel = uat::simulate_ensemble<cell>({.runs = 12, .seed = 5, .threads = 4}, setup, concatenate, std::string{});
+  CHECK(parallel == sequential);
+  CHECK(sequential.size() > 12 * 3);
+}
+
+TEST_CASE("runs with recycled buckets match fresh runs", "[ensemble]")
+{
+  uat::thread_pool pool(3);
+  const auto first = run_ensemble(pool);
+  const auto second = run_ensemble(pool); // Workers now reuse the buckets of the first ensemble.
+  CHECK(second == first);
+
+  // A run on a thread that does not recycle buckets.
+  std::string alone;
+  auto opts = setup(0, alone);
+  opts.seed = uat::ensemble_seeds(12, 5).front();
+  uat::simulate<cell>(opts);
+  CHECK(first.starts_with(alone + "--\n"));
+}
@@ -0,0 +1,154 @@
+//! \file fixture.hpp
+//! \brief Regions and agents shared by the tests.
+
+#ifndef UAT_TEST_FIXTURE_HPP
+#define UAT_TEST_FIXTURE_HPP
+
+#include <uat/simulation.hpp>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fixture
+{
+
+//! Number of cells in the airspace of the tests.
+constexpr std::uint32_t cells = 16;
+
+//! A cell of a one-dimensional airspace, stored in a hashed book.
+struct cell
+{
+  std::uint32_t id;
+
+  auto operator==(const cell& other) const noexcept -> bool { return id == other.id; }
+  auto operator!=(const cell& other) const noexcept -> bool { return id != other.id; }
+};
+
+} // namespace fixture
+
+namespace fixture
+{
+
+//! The same cell, stored in a dense book (see \ref uat::region_index).
+struct dense_cell
+{
+  std::uint32_t id;
+
+  auto operator==(const dense_cell& other) const noexcept -> bool { return id == other.id; }
+  auto operator!=(const dense_cell& other) const noexcept -> bool { return id != other.id; }
+};
+
+} // namespace fixture
+
+template <> struct std::hash<fixture::cell>
+{
+  auto operator()(const fixture::cell& c) const noexcept -> std::size_t { return std::hash<std::uint32_t>{}(c.id); }
+};
+
+template <> struct std::hash<fixture::dense_cell>
+{
+  auto operator()(const fixture::dense_cell& c) const noexcept -> std::size_t { return std::hash<std::uint32_t>{}(c.id); }
+};
+
+template <> struct uat::region_index<fixture::dense_cell>
+{
+  static auto index(const fixture::dense_cell& c) -> std::size_t { return c.id; }
+  static auto bound() -> std::size_t { return fixture::cells; }
+};
+
+namespace fixture
+{
+
+//! \brief Agent that bids for random permits around its home cell and resells some of them.
+//!
+//! Every decision comes from the seeds given by the simulation, so runs are reproducible.  `R`
+//! is any region with a public `std::uint32_t id` member.
+template <typename R> class trader : public uat::agent<R>
+{
+public:
+  trader(std::uint32_t home, uat::uint_t last_step) : home_(home), last_step_(last_step) {}
+
+  auto bid_phase(uat::uint_t time, uat::bid_fn bid, uat::permit_public_status_fn status, int seed) -> void override
+  {
+    std::mt19937 rng(static_cast<unsigned>(seed));
+    for (int i = 0; i < 3; ++i) {
+      const R region{static_cast<std::uint32_t>((home_ + rng() % 5) % cells)};
+      const auto t = time + 1 + rng() % 4;
+      if (std::holds_alternative<uat::permit_public_status::available>(status(region, t)))
+        bid(region, t, 0.5 + (rng() % 100) / 50.0);
+    }
+  }
+
+  auto ask_phase(uat::uint_t, uat::ask_fn ask, uat::permit_public_status_fn, int seed) -> void override
+  {
+    std::mt19937 rng(static_cast<unsigned>(seed));
+    for (const auto& [id, t] : owned_)
+      if (rng() % 2)
+        ask(R{id}, t, 0.3);
+    owned_.clear();
+  }
+
+  auto on_bought(const R& region, uat::uint_t time, uat::value_t) -> void override { owned_.emplace_back(region.id, time); }
+
+  auto stop(uat::uint_t time, int) -> bool override { return time >= last_step_; }
+
+  auto serialize(std::ostream& os) const -> void override
+  {
+    uat::write_binary(os, home_);
+    uat::write_binary(os, last_step_);
+    uat::write_binary(os, owned_.size());
+    for (const auto& [id, t] : owned_) {
+      uat::write_binary(os, id);
+      uat::write_binary(os, t);
+    }
+  }
+
+  //! Restores an agent written by \ref serialize.
+  static auto deserialize(std::istream& is) -> uat::any_agent
+  {
+    const auto home = uat::read_binary<std::uint32_t>(is);
+    trader agent(home, uat::read_binary<uat::uint_t>(is));
+    agent.owned_.resize(uat::read_binary<std::size_t>(is));
+    for (auto& [id, t] : agent.owned_) {
+      id = uat::read_binary<std::uint32_t>(is);
+      t = uat::read_binary<uat::uint_t>(is);
+    }
+    return agent;
+  }
+
+private:
+  std::uint32_t home_;
+  uat::uint_t last_step_;
+  std::vector<std::pair<std::uint32_t, uat::uint_t>> owned_;
+};
+
+//! Factory creating five traders per step until `arrivals` steps have passed.
+template <typename R> auto trader_factory(uat::uint_t arrivals = 40) -> uat::factory_t
+{
+  return [arrivals](uat::uint_t t, int seed) {
+    std::vector<uat::any_agent> agents;
+    std::mt19937 rng(static_cast<unsigned>(seed));
+    if (t < arrivals)
+      for (int i = 0; i < 5; ++i) {
+        const auto home = static_cast<std::uint32_t>(rng() % cells); // Drawn in order, unlike arguments.
+        agents.push_back(trader<R>(home, t + 5 + rng() % 10));
+      }
+    return agents;
+  };
+}
+
+//! Trade callback that appends every trade to a string, one per line.
+template <typename R> auto record_trades(std::string& out) -> uat::trade_callback_t<R>
+{
+  return [&out](const uat::trade_info_t<R>& trade) {
+    out += std::to_string(trade.transaction_time) + ' ' + std::to_string(trade.from) + ' ' + std::to_string(trade.to) + ' ' +
+           std::to_string(trade.location.id) + ' ' + std::to_string(trade.time) + ' ' + std::to_string(trade.value) + '\n';
+  };
+}
+
+} // namespace fixture
+
+#endif // UAT_TEST_FIXTURE_HPP
@@ -0,0 +1,103 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <uat/thread_pool.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using fixture::cell;
+
+namespace
+{
+
+//! Trader that writes the permits it buys and sells to its own ledger.
+class ledger_trader : public fixture::trader<cell>
+{
+public:
+  ledger_trader(std::uint32_t home, uat::uint_t last_step, std::string& ledger)
+    : fixture::trader<cell>(home, last_step), ledger_(&ledger)
+  {}
+
+  auto on_bought(const cell& region, uat::uint_t time, uat::value_t value) -> void override
+  {
+    *ledger_ += "bought " + std::to_string(region.id) + ' ' + std::to_string(time) + ' ' + std::to_string(value) + '\n';
+    fixture::trader<cell>::on_bought(region, time, value);
+  }
+
+  auto on_sold(const cell& region, uat::uint_t time, uat::value_t value) -> void override
+  {
+    *ledger_ += "sold " + std::to_string(region.id) + ' ' + std::to_string(time) + ' ' + std::to_string(value) + '\n';
+  }
+
+private:
+  std::string* ledger_;
+};
+
+constexpr uat::uint_t arrivals = 40;
+
+//! What a run produced: its trades, the active agents after each step and the ledger of each agent.
+struct run_t
+{
+  std::string trades;
+  std::vector<std::vector<uat::id_t>> active;
+  std::vector<std::string> ledgers = std::vector<std::string>(5 * arrivals);
+};
+
+//! Same agents as `fixture::trader_factory`, each with a ledger of its own (so that agents on
+//! different workers never write to the same one).
+auto ledger_factory(std::vector<std::string>& ledgers) -> uat::factory_t
+{
+  return [&ledgers, next = std::size_t{0}](uat::uint_t t, int seed) mutable {
+    std::vector<uat::any_agent> agents;
+    std::mt19937 rng(static_cast<unsigned>(seed));
+    if (t < arrivals)
+      for (int i = 0; i < 5; ++i) {
+        const auto home = static_cast<std::uint32_t>(rng() % fixture::cells);
+        agents.push_back(ledger_trader(home, t + 5 + rng() % 10, ledgers.at(next++)));
+      }
+    return agents;
+  };
+}
+
+auto run(uat::thread_pool* pool, uat::uint_t report_depth) -> run_t
+{
+  run_t result;
+  uat::simulation<cell> sim({
+    .factory = ledger_factory(result.ledgers),
+    .trade_callback = fixture::record_trades<cell>(result.trades),
+    .seed = 13,
+    .pool = pool,
+    .report_depth = report_depth,
+  });
+  while (!sim.finished()) {
+    sim.step();
+    const auto active = sim.agents().active();
+    result.active.emplace_back(active.begin(), active.end());
+  }
+  sim.flush();
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("runs on a thread pool match sequential runs", "[parallel]")
+{
+  const auto sequential = run(nullptr, 0);
+  REQUIRE(!sequential.trades.empty());
+  REQUIRE(std::ranges::any_of(sequential.ledgers, [](const auto& ledger) { return ledger.find("sold") != std::string::npos; }));
+
+  uat::thread_pool pool(4);
+  for (const uat::uint_t depth : {0, 1, 4}) {
+    const auto parallel = run(&pool, depth);
+    CHECK(parallel.trades == sequential.trades);
+    CHECK(parallel.active == sequential.active); // Stopped agents are removed in place, keeping the order.
+    CHECK(parallel.ledgers == sequential.ledgers); // Each agent settles its trades in the sequential order.
+  }
+
+  const auto pipelined = run(nullptr, 2);
+  CHECK(pipelined.trades == sequential.trades);
+}
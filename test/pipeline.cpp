@@ -0,0 +1,137 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using fixture::cell;
+
+TEST_CASE("reports are delivered in the order of the steps", "[pipeline]")
+{
+  std::string sequential;
+  uat::simulate<cell>({.factory = fixture::trader_factory<cell>(), .trade_callback = fixture::record_trades<cell>(sequential), .seed = 14});
+  REQUIRE(!sequential.empty());
+
+  for (const uat::uint_t depth : {1, 3}) {
+    std::string trades;
+    std::vector<uat::uint_t> steps;
+    std::vector<std::thread::id> threads;
+    uat::simulation<cell> sim({
+      .factory = fixture::trader_factory<cell>(),
+      .trade_callback = fixture::record_trades<cell>(trades),
+      .seed = 14,
+      .delta_callback =
+        [&](const uat::step_changes_t<cell>& changes) {
+          steps.push_back(changes.time);
+          threads.push_back(std::this_thread::get_id());
+        },
+      .report_depth = depth,
+    });
+    sim.run();
+
+    CHECK(trades == sequential);
+    REQUIRE(steps.size() == sim.time());
+    for (uat::uint_t t = 0; t < steps.size(); ++t)
+      CHECK(steps[t] == t);
+    CHECK(std::ranges::none_of(threads, [](const auto id) { return id == std::this_thread::get_id(); }));
+  }
+}
+
+TEST_CASE("steps block while the reports fill the queue", "[pipeline]")
+{
+  constexpr uat::uint_t depth = 2, steps = 8;
+  std::promise<void> release;
+  const auto released = release.get_future().share();
+
+  uat::simulation<cell> sim({
+    .factory = fixture::trader_factory<cell>(),
+    .seed = 14,
+    .delta_callback = [released](const uat::step_changes_t<cell>&) { released.wait(); },
+    .report_depth = depth,
+  });
+
+  // The first report is held by the callback, and `depth` more fill the queue.
+  std::atomic<uat::uint_t> done = 0;
+  std::thread producer([&] {
+    for (uat::uint_t i = 0; i < steps; ++i) {
+      sim.step();
+      ++done;
+    }
+  });
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (done < depth && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  CHECK(done == depth);
+
+  release.set_value();
+  producer.join();
+  CHECK(done == steps);
+  sim.flush();
+}
+
+TEST_CASE("callback errors are rethrown before the next step changes anything", "[pipeline]")
+{
+  constexpr uat::uint_t failing_step = 3;
+  uat::uint_t callbacks = 0;
+  uat::simulation<cell> sim({
+    .factory = fixture::trader_factory<cell>(),
+    .simulation_callback = [&](uat::uint_t, const uat::agents_private_status_t&, uat::book_view) { ++callbacks; },
+    .seed = 14,
+    .delta_callback =
+      [](const uat::step_changes_t<cell>& changes) {
+        if (changes.time == failing_step)
+          throw std::runtime_error{"delta callback failed"};
+      },
+    .report_depth = 2,
+  });
+
+  SECTION("by a later step")
+  {
+    // At most `report_depth` reports await delivery, so the error surfaces within a few steps.
+    bool thrown = false;
+    for (int i = 0; i < 10 && !thrown; ++i) {
+      const auto time = sim.time();
+      const auto active = sim.agents().active_count();
+      const auto calls = callbacks;
+      try {
+        sim.step();
+      } catch (const std::runtime_error&) {
+        thrown = true;
+        CHECK(time > failing_step);
+        CHECK(sim.time() == time);
+        CHECK(sim.agents().active_count() == active);
+        CHECK(callbacks == calls);
+      }
+    }
+    REQUIRE(thrown);
+
+    // The error is only rethrown once, and the simulation goes on from where it was.
+    const auto time = sim.time();
+    sim.step();
+    CHECK(sim.time() == time + 1);
+    CHECK_NOTHROW(sim.flush());
+  }
+
+  SECTION("by flush")
+  {
+    for (uat::uint_t i = 0; i <= failing_step; ++i)
+      sim.step();
+    CHECK_THROWS_AS(sim.flush(), std::runtime_error);
+    CHECK(sim.time() == failing_step + 1);
+    CHECK_NOTHROW(sim.flush());
+  }
+
+  SECTION("by run")
+  {
+    CHECK_THROWS_AS(sim.run(), std::runtime_error);
+    CHECK(sim.time() > failing_step);
+  }
+}
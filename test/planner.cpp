@@ -0,0 +1,179 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <uat/planner.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+
+using fixture::cell;
+
+namespace
+{
+
+//! The cells form a `side` x `side` grid.
+constexpr std::uint32_t side = 4;
+static_assert(side * side == fixture::cells);
+
+constexpr uat::uint_t horizon = 16;
+constexpr auto infinity = std::numeric_limits<uat::value_t>::infinity();
+
+auto x(const cell& c) -> int { return static_cast<int>(c.id % side); }
+auto y(const cell& c) -> int { return static_cast<int>(c.id / side); }
+
+//! The cell itself and its four neighbors.
+auto neighbors(const cell& c) -> std::vector<cell>
+{
+  std::vector<cell> result{c};
+  if (x(c) > 0)
+    result.push_back({c.id - 1});
+  if (x(c) + 1 < static_cast<int>(side))
+    result.push_back({c.id + 1});
+  if (y(c) > 0)
+    result.push_back({c.id - side});
+  if (y(c) + 1 < static_cast<int>(side))
+    result.push_back({c.id + side});
+  return result;
+}
+
+auto manhattan(const cell& a, const cell& b) -> uat::value_t { return std::abs(x(a) - x(b)) + std::abs(y(a) - y(b)); }
+
+//! Random public status of every permit of the grid up to the horizon.
+struct airspace
+{
+  std::array<std::array<uat::permit_public_status_t, horizon>, fixture::cells> status;
+
+  explicit airspace(std::mt19937& rng)
+  {
+    std::uniform_real_distribution<uat::value_t> value(0.0, 3.0);
+    for (auto& permits : status)
+      for (auto& s : permits) {
+        const auto kind = rng() % 10;
+        if (kind < 3)
+          s = uat::permit_public_status::unavailable{};
+        else if (kind < 4)
+          s = uat::permit_public_status::owned{};
+        else
+          s = uat::permit_public_status::available{.min_value = value(rng)};
+      }
+  }
+
+  auto operator()(const cell& c, uat::uint_t t) const -> const uat::permit_public_status_t& { return status[c.id][t]; }
+
+  //! Cost of the cheapest route, found by exhausting every departure and duration.
+  auto cheapest(const cell& from, const cell& to, const uat::planner_opts_t& opts) const -> uat::value_t
+  {
+    const auto cost = [&](const cell& c, uat::uint_t t) {
+      const auto& s = (*this)(c, t);
+      return std::holds_alternative<uat::permit_public_status::unavailable>(s) ? infinity : uat::min_value_cost{}(c, t, s);
+    };
+
+    auto best = infinity;
+    for (auto departure = opts.earliest_departure; departure <= opts.latest_departure; ++departure) {
+      std::array<uat::value_t, fixture::cells> layer;
+      layer.fill(infinity);
+      layer[from.id] = cost(from, departure);
+      for (auto t = departure;; ++t) {
+        best = std::min(best, layer[to.id]);
+        if (t + 1 - departure >= opts.max_duration)
+          break;
+        std::array<uat::value_t, fixture::cells> next;
+        next.fill(infinity);
+        for (std::uint32_t id = 0; id < fixture::cells; ++id)
+          if (id != to.id && layer[id] < infinity) // Routes end at the first visit to the destination.
+            for (const auto& n : neighbors(cell{id}))
+              next[n.id] = std::min(next[n.id], layer[id] + cost(n, t + 1));
+        layer = next;
+      }
+    }
+    return best;
+  }
+};
+
+} // namespace
+
+TEST_CASE("planned routes are as cheap as the cheapest route", "[planner]")
+{
+  std::mt19937 rng(7);
+  int found = 0, missing = 0;
+  for (int i = 0; i < 200; ++i) {
+    const airspace space(rng);
+    const cell from{static_cast<std::uint32_t>(rng() % fixture::cells)}, to{static_cast<std::uint32_t>(rng() % fixture::cells)};
+    const uat::planner_opts_t opts{.earliest_departure = rng() % 3, .latest_departure = 3, .max_duration = horizon - 4};
+
+    std::map<std::pair<std::uint32_t, uat::uint_t>, int> queries;
+    const auto lookup = [&](uat::region_view region, uat::uint_t t) -> uat::permit_public_status_t {
+      const auto& c = region.downcast<cell>();
+      ++queries[{c.id, t}];
+      return space(c, t);
+    };
+    const auto expected = space.cheapest(from, to, opts);
+
+    for (const auto zero_heuristic : {false, true}) {
+      queries.clear();
+      const auto heuristic = [&](const cell& a, const cell& b) { return zero_heuristic ? 0.0 : manhattan(a, b); };
+      const auto plan = uat::plan_route(uat::permit_public_status_fn(lookup), from, to, opts, neighbors, heuristic);
+      CHECK(std::ranges::all_of(queries, [](const auto& entry) { return entry.second == 1; }));
+
+      if (expected == infinity) {
+        CHECK_FALSE(plan);
+        missing += !plan;
+        continue;
+      }
+      REQUIRE(plan);
+      ++found;
+      CHECK(plan->cost == Approx(expected));
+
+      // The route is a valid sequence of usable permits whose costs add up to the plan's cost.
+      const auto& permits = plan->permits;
+      REQUIRE_FALSE(permits.empty());
+      CHECK(permits.front().location == from);
+      CHECK(permits.back().location == to);
+      CHECK(permits.front().time >= opts.earliest_departure);
+      CHECK(permits.front().time <= opts.latest_departure);
+      CHECK(permits.size() <= opts.max_duration);
+      uat::value_t total = 0.0;
+      for (std::size_t j = 0; j < permits.size(); ++j) {
+        const auto& [location, t] = permits[j];
+        const auto& s = space(location, t);
+        CHECK_FALSE(std::holds_alternative<uat::permit_public_status::unavailable>(s));
+        total += uat::min_value_cost{}(location, t, s);
+        if (j > 0) {
+          CHECK(t == permits[j - 1].time + 1);
+          CHECK(manhattan(location, permits[j - 1].location) <= 1);
+        }
+      }
+      CHECK(total == Approx(plan->cost));
+    }
+  }
+  CHECK(found > 100);
+  CHECK(missing > 0);
+}
+
+TEST_CASE("routes never exceed the maximum duration", "[planner]")
+{
+  // With every permit available, crossing the grid takes 2 * (side - 1) + 1 permits.
+  const auto lookup = [](uat::region_view, uat::uint_t) -> uat::permit_public_status_t {
+    return uat::permit_public_status::available{.min_value = 0.0};
+  };
+  const auto heuristic = [](const cell& a, const cell& b) { return manhattan(a, b); };
+  const cell from{0}, to{fixture::cells - 1};
+  const auto shortest = 2 * (side - 1) + 1;
+
+  const auto fits = uat::plan_route(uat::permit_public_status_fn(lookup), from, to,
+                                    {.earliest_departure = 0, .latest_departure = 0, .max_duration = shortest}, neighbors, heuristic);
+  REQUIRE(fits);
+  CHECK(fits->permits.size() == shortest);
+  CHECK(fits->cost == Approx(shortest));
+
+  const auto too_short = uat::plan_route(uat::permit_public_status_fn(lookup), from, to,
+                                         {.earliest_departure = 0, .latest_departure = 0, .max_duration = shortest - 1},
+                                         neighbors, heuristic);
+  CHECK_FALSE(too_short);
+}
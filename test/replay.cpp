@@ -0,0 +1,138 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <uat/replay.hpp>
+#include <uat/thread_pool.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using fixture::cell;
+
+namespace
+{
+
+auto options(std::string& trades) -> uat::simulation_opts_t<cell>
+{
+  return {.trade_callback = fixture::record_trades<cell>(trades), .seed = 12};
+}
+
+//! Agent that looks up cells outside the airspace of the traders in its ask phase, so that
+//! recording it interns new regions.
+class surveyor : public uat::agent<cell>
+{
+public:
+  auto ask_phase(uat::uint_t t, uat::ask_fn, uat::permit_public_status_fn status, int seed) -> void override
+  {
+    for (std::uint32_t i = 0; i < 8; ++i)
+      (void)status(cell{fixture::cells + static_cast<std::uint32_t>(seed) % 4096 + i}, t + 1);
+  }
+
+  auto stop(uat::uint_t t, int) -> bool override { return t % 3 == 0; }
+};
+
+//! Traders, together with surveyors that do not trade.
+auto surveyed_factory() -> uat::factory_t
+{
+  return [traders = fixture::trader_factory<cell>()](uat::uint_t t, int seed) {
+    auto agents = traders(t, seed);
+    if (t < 40)
+      for (int i = 0; i < 8; ++i)
+        agents.push_back(surveyor{});
+    return agents;
+  };
+}
+
+auto bytes(const uat::decision_log<cell>& log) -> std::string
+{
+  std::ostringstream os;
+  log.save(os);
+  return os.str();
+}
+
+} // namespace
+
+TEST_CASE("replays reproduce the recorded trades", "[replay]")
+{
+  std::string recorded, replayed;
+  uat::decision_log<cell> log;
+
+  auto opts = options(recorded);
+  opts.factory = log.record(fixture::trader_factory<cell>());
+  uat::simulate<cell>(opts);
+  REQUIRE(log.agents() > 0);
+  REQUIRE(!recorded.empty());
+
+  opts = options(replayed);
+  opts.factory = log.replay();
+  uat::simulate<cell>(opts);
+  CHECK(replayed == recorded);
+}
+
+TEST_CASE("saved logs load back to the same decisions", "[replay]")
+{
+  std::string recorded, replayed;
+  uat::decision_log<cell> log;
+  auto opts = options(recorded);
+  opts.factory = log.record(fixture::trader_factory<cell>());
+  uat::simulate<cell>(opts);
+
+  const auto saved = bytes(log);
+
+  uat::decision_log<cell> loaded;
+  std::istringstream is(saved);
+  loaded.load(is);
+  CHECK(bytes(loaded) == saved);
+  REQUIRE(loaded.agents() == log.agents());
+  CHECK(loaded.regions() == log.regions());
+  for (std::size_t i = 0; i < log.agents(); ++i) {
+    const auto& expected = log.decisions(i);
+    const auto& actual = loaded.decisions(i);
+    REQUIRE(actual.size() == expected.size());
+    for (std::size_t j = 0; j < expected.size(); ++j) {
+      CHECK(actual[j].kind == expected[j].kind);
+      CHECK(actual[j].region == expected[j].region);
+      CHECK(actual[j].time == expected[j].time);
+      CHECK(actual[j].value == expected[j].value);
+    }
+  }
+
+  opts = options(replayed);
+  opts.factory = loaded.replay();
+  uat::simulate<cell>(opts);
+  CHECK(replayed == recorded);
+
+  std::istringstream truncated(saved.substr(0, saved.size() - 1));
+  CHECK_THROWS_AS(loaded.load(truncated), std::runtime_error);
+}
+
+TEST_CASE("agents recorded on a thread pool replay to the same trades", "[replay]")
+{
+  std::string sequential, recorded, replayed, replayed_in_pool;
+  uat::thread_pool pool(4);
+
+  auto opts = options(sequential);
+  opts.factory = surveyed_factory();
+  uat::simulate<cell>(opts);
+
+  uat::decision_log<cell> log;
+  opts = options(recorded);
+  opts.factory = log.record(surveyed_factory());
+  opts.pool = &pool; // Surveyors intern new regions concurrently.
+  uat::simulate<cell>(opts);
+  CHECK(recorded == sequential);
+  CHECK(log.regions().size() > fixture::cells);
+
+  opts = options(replayed);
+  opts.factory = log.replay();
+  uat::simulate<cell>(opts);
+  CHECK(replayed == recorded);
+
+  opts = options(replayed_in_pool);
+  opts.factory = log.replay();
+  opts.pool = &pool;
+  uat::simulate<cell>(opts);
+  CHECK(replayed_in_pool == recorded);
+}
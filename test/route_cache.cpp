@@ -0,0 +1,159 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <uat/route_cache.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using fixture::cell;
+
+namespace
+{
+
+//! The cells form a line; a step moves to an adjacent cell or hovers.
+auto neighbors(const cell& c) -> std::vector<cell>
+{
+  std::vector<cell> result{c};
+  if (c.id > 0)
+    result.push_back({c.id - 1});
+  if (c.id + 1 < fixture::cells)
+    result.push_back({c.id + 1});
+  return result;
+}
+
+auto distance(const cell& a, const cell& b) -> uat::value_t { return std::abs(static_cast<int>(a.id) - static_cast<int>(b.id)); }
+
+//! Plans the route of the tests: cells 0 to 3 at times 2 to 5 when every permit is free.
+auto plan(uat::route_cache<cell>& cache, uat::permit_public_status_fn status)
+{
+  return cache.plan(status, cell{0}, cell{3}, {.earliest_departure = 2, .latest_departure = 2}, neighbors, distance);
+}
+
+//! Agent whose phases are given by functions, and that stops after `last_step`.
+class scripted : public uat::agent<cell>
+{
+public:
+  using bid_script = std::function<void(uat::uint_t, uat::bid_fn, uat::permit_public_status_fn)>;
+  using ask_script = std::function<void(uat::uint_t, uat::ask_fn)>;
+
+  scripted(uat::uint_t last_step, bid_script bid, ask_script ask = {}) : last_step_(last_step), bid_(bid), ask_(ask) {}
+
+  auto bid_phase(uat::uint_t t, uat::bid_fn bid, uat::permit_public_status_fn status, int) -> void override { bid_(t, bid, status); }
+
+  auto ask_phase(uat::uint_t t, uat::ask_fn ask, uat::permit_public_status_fn, int) -> void override
+  {
+    if (ask_)
+      ask_(t, ask);
+  }
+
+  auto stop(uat::uint_t t, int) -> bool override { return t >= last_step_; }
+
+private:
+  uat::uint_t last_step_;
+  bid_script bid_;
+  ask_script ask_;
+};
+
+//! Simulation with the given agents entering at the first step and sharing the cache.
+auto make_simulation(uat::route_cache<cell>& cache, std::vector<scripted> agents) -> uat::simulation<cell>
+{
+  return uat::simulation<cell>({
+    .factory = [agents = std::move(agents)](uat::uint_t t, int) {
+      return t == 0 ? std::vector<uat::any_agent>(agents.begin(), agents.end()) : std::vector<uat::any_agent>{};
+    },
+    .routes = &cache,
+  });
+}
+
+} // namespace
+
+TEST_CASE("trades on a cached route drop it", "[route_cache]")
+{
+  uat::route_cache<cell> cache;
+  const auto pilot = scripted(1, [&](uat::uint_t t, uat::bid_fn, uat::permit_public_status_fn status) {
+    const auto route = plan(cache, status);
+    REQUIRE(route);
+    if (t == 0)
+      CHECK(route->permits.size() == 4);
+  });
+
+  SECTION("a permit on the route is traded")
+  {
+    auto sim = make_simulation(cache, {pilot, scripted(0, [](uat::uint_t, uat::bid_fn bid, auto) { bid(cell{2}, 4, 1.0); })});
+    sim.step();
+    CHECK(cache.size() == 0);
+    sim.step();
+    CHECK(cache.misses() == 2);
+    CHECK(cache.hits() == 0);
+  }
+
+  SECTION("a permit off the route is traded")
+  {
+    auto sim = make_simulation(cache, {pilot, scripted(0, [](uat::uint_t, uat::bid_fn bid, auto) { bid(cell{5}, 4, 1.0); })});
+    sim.step();
+    CHECK(cache.size() == 1);
+    sim.step();
+    CHECK(cache.misses() == 1);
+    CHECK(cache.hits() == 1);
+  }
+}
+
+TEST_CASE("asks on a cached route drop it", "[route_cache]")
+{
+  uat::route_cache<cell> cache;
+  std::vector<std::vector<uat::permit<cell>>> routes;
+  const auto buy_then_plan = [&](uat::uint_t t, uat::bid_fn bid, uat::permit_public_status_fn status) {
+    if (t == 0) {
+      bid(cell{1}, 3, 1.0);
+    } else {
+      const auto route = plan(cache, status);
+      REQUIRE(route);
+      routes.push_back(route->permits);
+    }
+  };
+
+  SECTION("the owner puts a permit of the route on sale")
+  {
+    auto sim = make_simulation(cache, {scripted(2, buy_then_plan, [](uat::uint_t t, uat::ask_fn ask) {
+                                         if (t == 1)
+                                           ask(cell{1}, 3, 5.0);
+                                       })});
+    sim.step();
+    sim.step();
+    CHECK(cache.size() == 0);
+    sim.step();
+    CHECK(cache.misses() == 2);
+  }
+
+  SECTION("the owner keeps the permits of the route")
+  {
+    auto sim = make_simulation(cache, {scripted(2, buy_then_plan)});
+    sim.step();
+    sim.step();
+    CHECK(cache.size() == 1);
+    sim.step();
+    CHECK(cache.misses() == 1);
+    CHECK(cache.hits() == 1);
+  }
+
+  // Owned permits are usable, so the route goes through the one bought by the agent.
+  REQUIRE(!routes.empty());
+  CHECK(std::ranges::count(routes.front(), uat::permit<cell>{cell{1}, 3}) == 1);
+}
+
+TEST_CASE("cached routes are dropped once their departure is past", "[route_cache]")
+{
+  uat::route_cache<cell> cache;
+  auto sim = make_simulation(cache, {scripted(0, [&](uat::uint_t, uat::bid_fn, uat::permit_public_status_fn status) {
+                                       REQUIRE(plan(cache, status));
+                                     })});
+  sim.step();
+  sim.step();
+  CHECK(cache.size() == 1); // Departs at time 2.
+  sim.step();
+  CHECK(cache.size() == 0);
+}
@@ -0,0 +1,109 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "counting_allocator.hpp"
+#include "fixture.hpp"
+
+#include <memory_resource>
+#include <optional>
+
+using counting_allocator::allocations;
+using fixture::cell;
+
+namespace
+{
+
+//! One agent per cell (cells are hashed, so ids are not limited to `fixture::cells`).
+constexpr std::uint32_t agent_count = 64;
+
+//! \brief Agent that buys a permit of its own cell in every step and resells it right away,
+//! while also bidding on the cell of its neighbor.
+//!
+//! Unlike \ref fixture::trader, which keeps its permits in a vector, this agent never allocates,
+//! so every allocation counted in the steady state comes from the engine.
+class reseller : public uat::agent<cell>
+{
+public:
+  explicit reseller(std::uint32_t id) : id_(id) {}
+
+  auto bid_phase(uat::uint_t time, uat::bid_fn bid, uat::permit_public_status_fn status, int) -> void override
+  {
+    bid(cell{id_}, time + 1, 1.0);
+    bid(cell{(id_ + 1) % agent_count}, time + 2, 0.5);
+    (void)status(cell{id_}, time + 3);
+  }
+
+  auto ask_phase(uat::uint_t, uat::ask_fn ask, uat::permit_public_status_fn, int) -> void override
+  {
+    if (bought_)
+      ask(cell{id_}, *bought_, 0.1);
+    bought_.reset();
+  }
+
+  auto on_bought(const cell& region, uat::uint_t time, uat::value_t) -> void override
+  {
+    if (region.id == id_)
+      bought_ = time;
+  }
+
+  auto stop(uat::uint_t, int) -> bool override { return false; }
+
+private:
+  std::uint32_t id_;
+  std::optional<uat::uint_t> bought_;
+};
+
+auto allocations_in_steady_state(uat::simulation<cell>& sim) -> std::uint64_t
+{
+  for (int i = 0; i < 100; ++i) // warm-up
+    sim.step();
+
+  const auto before = allocations();
+  for (int i = 0; i < 5000; ++i)
+    sim.step();
+  return allocations() - before;
+}
+
+} // namespace
+
+TEST_CASE("steady state performs no heap allocations", "[memory]")
+{
+  std::pmr::unsynchronized_pool_resource book_pool, step_pool;
+  uat::uint_t trades = 0;
+
+  uat::simulation<cell> sim({
+    .factory = [](uat::uint_t t, int) {
+      std::vector<uat::any_agent> agents;
+      if (t == 0)
+        for (std::uint32_t i = 0; i < agent_count; ++i)
+          agents.push_back(reseller{i});
+      return agents;
+    },
+    .trade_callback = [&trades](const uat::trade_info_t<cell>&) { ++trades; },
+    .seed = 17,
+    .memory = {.book = &book_pool,
+               .transient = &step_pool,
+               .agents_capacity = agent_count,
+               .bids_capacity = 2 * agent_count,
+               .asks_capacity = agent_count},
+  });
+
+  CHECK(allocations_in_steady_state(sim) == 0);
+  CHECK(trades > 0);
+}
+
+TEST_CASE("default resources allocate book entries", "[memory]")
+{
+  uat::simulation<cell> sim({
+    .factory = [](uat::uint_t t, int) {
+      std::vector<uat::any_agent> agents;
+      if (t == 0)
+        for (std::uint32_t i = 0; i < agent_count; ++i)
+          agents.push_back(reseller{i});
+      return agents;
+    },
+    .seed = 17,
+  });
+
+  // The counter itself is checked: without pools, new book entries come from the heap.
+  CHECK(allocations_in_steady_state(sim) > 0);
+}
@@ -0,0 +1,124 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+using fixture::cell;
+using namespace uat::stop_criterion;
+
+namespace
+{
+
+constexpr uat::uint_t horizon = 200;
+
+//! Time at which the simulation stops with the given criterion.
+auto stop_time(uat::stop_criterion_t criterion) -> uat::uint_t
+{
+  uat::simulation<cell> sim({.factory = fixture::trader_factory<cell>(), .stop_criterion = std::move(criterion), .seed = 6});
+  sim.run_until(horizon);
+  return sim.time();
+}
+
+//! Number of trades and of active agents at the end of each step of the run.
+struct reference_t
+{
+  std::vector<uat::uint_t> trades;
+  std::vector<uat::uint_t> active;
+
+  reference_t()
+  {
+    trades.assign(horizon, 0);
+    uat::simulation<cell> sim({
+      .factory = fixture::trader_factory<cell>(),
+      .stop_criterion = time_threshold_t{horizon},
+      .trade_callback = [&](const uat::trade_info_t<cell>& trade) { ++trades[trade.transaction_time]; },
+      .seed = 6,
+    });
+    while (sim.time() < horizon) {
+      sim.step();
+      active.push_back(sim.agents().active_count());
+    }
+  }
+
+  //! First time step, after the first one, at which the condition on the previous steps holds.
+  auto first(const std::function<bool(uat::uint_t)>& satisfied) const -> uat::uint_t
+  {
+    for (uat::uint_t t = 1; t < horizon; ++t)
+      if (satisfied(t))
+        return t;
+    return horizon;
+  }
+
+  auto quiet(uat::uint_t t, uat::uint_t steps) const -> bool
+  {
+    for (uat::uint_t i = 1; i <= steps; ++i)
+      if (i > t || trades[t - i] > 0)
+        return false;
+    return true;
+  }
+
+  auto volume(uat::uint_t t, uat::uint_t window) const -> uat::uint_t
+  {
+    uat::uint_t sum = 0;
+    for (auto i = t - window; i < t; ++i)
+      sum += trades[i];
+    return sum;
+  }
+};
+
+auto reference() -> const reference_t&
+{
+  static const reference_t ref;
+  return ref;
+}
+
+} // namespace
+
+TEST_CASE("the reference run has busy and quiet steps", "[stop]")
+{
+  const auto& ref = reference();
+  CHECK(ref.trades[1] > 0);
+  CHECK(ref.active.back() == 0);
+  CHECK(ref.quiet(horizon - 1, 10));
+}
+
+TEST_CASE("single criteria stop at the expected step", "[stop]")
+{
+  const auto& ref = reference();
+
+  CHECK(stop_time(time_threshold_t{7}) == 8);
+  CHECK(stop_time(no_agents_t{}) == ref.first([&](uat::uint_t t) { return ref.active[t - 1] == 0; }));
+  for (const uat::uint_t steps : {1, 2, 5})
+    CHECK(stop_time(no_trades_t{steps}) == ref.first([&](uat::uint_t t) { return ref.quiet(t, steps); }));
+
+  for (const auto& [window, threshold] : {std::pair<uat::uint_t, uat::uint_t>{4, 10}, {1, 3}, {8, 40}}) {
+    const auto expected = ref.first([&](uat::uint_t t) { return t >= window && ref.volume(t, window) < threshold; });
+    CHECK(stop_time(trade_volume_below_t{window, threshold}) == expected);
+  }
+
+  // Budgets are only checked after the first step.
+  CHECK(stop_time(wall_clock_budget_t{std::chrono::nanoseconds{0}}) == 1);
+  CHECK(stop_time(cpu_budget_t{std::chrono::nanoseconds{0}}) == 1);
+  CHECK(stop_time(wall_clock_budget_t{std::chrono::hours{1}}) == horizon);
+  CHECK(stop_time(cpu_budget_t{std::chrono::hours{1}}) == horizon);
+}
+
+TEST_CASE("combined criteria stop at the expected step", "[stop]")
+{
+  const auto& ref = reference();
+  const auto quiet = ref.first([&](uat::uint_t t) { return ref.quiet(t, 2); });
+  REQUIRE(quiet > 10);
+
+  CHECK(stop_time(uat::any_of(time_threshold_t{5}, no_trades_t{2})) == 6);
+  CHECK(stop_time(uat::any_of(time_threshold_t{horizon}, no_trades_t{2})) == quiet);
+  CHECK(stop_time(uat::all_of(time_threshold_t{5}, no_trades_t{2})) == quiet);
+  CHECK(stop_time(uat::all_of(time_threshold_t{quiet + 3}, no_trades_t{2})) == quiet + 4);
+
+  // Nested criteria: a quiet period after step 20, or a budget that is never exhausted.
+  const auto later = ref.first([&](uat::uint_t t) { return t > 20 && ref.quiet(t, 2); });
+  CHECK(stop_time(uat::any_of(uat::all_of(time_threshold_t{20}, no_trades_t{2}), wall_clock_budget_t{std::chrono::hours{1}})) ==
+        later);
+}
@@ -0,0 +1,66 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <array>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using fixture::cell;
+
+namespace
+{
+
+auto count(const std::string& text, const std::string& pattern) -> std::size_t
+{
+  std::size_t n = 0;
+  for (auto i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + 1))
+    ++n;
+  return n;
+}
+
+auto json(const uat::tracer& t) -> std::string
+{
+  std::ostringstream os;
+  t.write(os);
+  return os.str();
+}
+
+} // namespace
+
+TEST_CASE("each step and phase is recorded", "[trace]")
+{
+  uat::tracer trace;
+  uat::simulation<cell> sim({.factory = fixture::trader_factory<cell>(), .seed = 2, .trace = &trace});
+  sim.run_until(10);
+
+  const auto events = json(trace);
+  CHECK(count(events, "\"name\":\"step\"") == 10);
+  CHECK(count(events, "\"name\":\"bid\"") == 10);
+  CHECK(count(events, "\"name\":\"bid_phase\"") == 0);
+  CHECK(count(events, "\"tid\":1") == 0);
+}
+
+TEST_CASE("threads alternating between tracers keep one buffer per tracer", "[trace]")
+{
+  std::array<std::unique_ptr<uat::tracer>, 6> tracers; // More than the buffers cached by a thread.
+  for (auto& t : tracers)
+    t = std::make_unique<uat::tracer>();
+
+  const auto record = [&] {
+    for (int round = 0; round < 50; ++round)
+      for (auto& t : tracers)
+        t->record({"event", t->now(), t->now(), 0, uat::tracer::no_agent});
+  };
+  record();
+  std::thread(record).join();
+
+  for (const auto& t : tracers) {
+    const auto events = json(*t);
+    CHECK(count(events, "\"tid\":0") == 50);
+    CHECK(count(events, "\"tid\":1") == 50);
+    CHECK(count(events, "\"tid\":2") == 0);
+  }
+}
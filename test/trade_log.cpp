@@ -0,0 +1,126 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using fixture::cell;
+
+namespace
+{
+
+//! Query that visits every permit.
+struct everything
+{
+  auto contains(const cell&) const -> bool { return true; }
+};
+
+//! Fields of a private status, with its whole history.
+using entry_t = std::tuple<std::size_t, uat::uint_t, uat::value_t, uat::uint_t, uat::value_t,
+                           std::vector<std::pair<uat::value_t, uat::value_t>>, uat::uint_t>;
+
+auto entry(const uat::permit_private_status_t& status) -> entry_t
+{
+  using namespace uat::permit_private_status;
+  entry_t e{status.current.index(), uat::no_owner, 0.0, uat::no_owner, 0.0, {}, status.market.count};
+  if (const auto* sale = std::get_if<on_sale>(&status.current))
+    std::tie(std::get<1>(e), std::get<2>(e), std::get<3>(e), std::get<4>(e)) =
+      std::tuple{sale->owner, sale->min_value, sale->highest_bidder, sale->highest_bid};
+  else if (const auto* use = std::get_if<in_use>(&status.current))
+    std::get<1>(e) = use->owner;
+  for (const auto& [min_value, highest_bid] : status.history)
+    std::get<5>(e).emplace_back(min_value, highest_bid);
+  return e;
+}
+
+using book_t = std::map<std::pair<std::uint32_t, uat::uint_t>, entry_t>;
+
+//! Adds a permit to a book, unless it is in its initial status.
+//!
+//! Agents looking up a permit may store it in the book without changing it, and keyframes keep
+//! such permits, while step blocks do not; both are reported like permits not stored at all.
+auto add(book_t& book, const cell& region, uat::uint_t t, const uat::permit_private_status_t& status) -> void
+{
+  if (entry(status) != entry(uat::permit_private_status_t{}))
+    book.emplace(std::pair{region.id, t}, entry(status));
+}
+
+auto live_book(const uat::simulation<cell>& sim) -> book_t
+{
+  book_t book;
+  sim.query(everything{}, 0, std::numeric_limits<uat::uint_t>::max(),
+            [&](const cell& region, uat::uint_t t, const uat::permit_private_status_t& status) { add(book, region, t, status); });
+  return book;
+}
+
+auto replayed_book(const uat::book_snapshot<cell>& snapshot) -> book_t
+{
+  book_t book;
+  snapshot.for_each([&](const cell& region, uat::uint_t t, const uat::permit_private_status_t& status) { add(book, region, t, status); });
+  return book;
+}
+
+} // namespace
+
+TEST_CASE("books rebuilt from the trade log match the live book", "[trade_log]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "uat_trade_log_test.bin";
+  constexpr uat::uint_t keyframe_every = 5;
+
+  // The live book at the beginning of each step.
+  std::vector<book_t> live;
+  {
+    uat::trade_log_writer<cell> writer(path, keyframe_every);
+    uat::simulation<cell> sim({.factory = fixture::trader_factory<cell>(), .seed = 10, .trade_log = &writer});
+    live.push_back(live_book(sim));
+    while (!sim.finished()) {
+      sim.step();
+      live.push_back(live_book(sim));
+    }
+  }
+  REQUIRE(live.size() > 4 * keyframe_every);
+
+  uat::trade_log_reader<cell> log(path);
+  CHECK(log.first_step() == 0);
+  CHECK(log.end_step() == live.size() - 1);
+
+  // Every step, at keyframes and between them, read in random order so that the reader seeks back and forth.
+  std::vector<uat::uint_t> steps(live.size());
+  for (uat::uint_t s = 0; s < steps.size(); ++s)
+    steps[s] = s;
+  std::shuffle(steps.begin(), steps.end(), std::mt19937(11));
+  std::size_t stored = 0;
+  for (const auto s : steps) {
+    const auto book = log.book_at(s);
+    CHECK(book.time() == s);
+    CHECK(replayed_book(book) == live[s]);
+    stored += live[s].size();
+  }
+  CHECK(stored > 0);
+
+  CHECK_THROWS_AS(log.book_at(log.end_step() + 1), std::out_of_range);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("book snapshots report past permits out of limits", "[trade_log]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "uat_trade_log_test_limits.bin";
+  {
+    uat::trade_log_writer<cell> writer(path, 3);
+    uat::simulation<cell> sim({.factory = fixture::trader_factory<cell>(), .seed = 10, .trade_log = &writer});
+    sim.run_until(10);
+  }
+
+  uat::trade_log_reader<cell> log(path);
+  const auto book = log.book_at(7);
+  CHECK(std::holds_alternative<uat::permit_private_status::out_of_limits>(book.status(cell{0}, 6).current));
+  CHECK_FALSE(std::holds_alternative<uat::permit_private_status::out_of_limits>(book.status(cell{0}, 7).current));
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,143 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <uat/simulation.hpp>
+#include <uat/voxel.hpp>
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using uat::voxel;
+
+namespace
+{
+
+constexpr std::uint32_t side = 16;
+
+auto random_box(std::mt19937& rng) -> uat::voxel_box
+{
+  std::uniform_int_distribution<std::uint32_t> coordinate(0, side - 1);
+  std::uint32_t lo[3], hi[3];
+  for (int i = 0; i < 3; ++i) {
+    lo[i] = coordinate(rng);
+    hi[i] = coordinate(rng);
+    if (lo[i] > hi[i])
+      std::swap(lo[i], hi[i]);
+  }
+  return {{lo[0], lo[1], lo[2]}, {hi[0], hi[1], hi[2]}};
+}
+
+//! Agent that bids for random voxels of a small grid and resells half of what it buys.
+class flyer : public uat::agent<voxel>
+{
+public:
+  auto bid_phase(uat::uint_t time, uat::bid_fn bid, uat::permit_public_status_fn, int seed) -> void override
+  {
+    std::mt19937 rng(static_cast<unsigned>(seed));
+    for (int i = 0; i < 4; ++i)
+      bid(voxel(rng() % 8, rng() % 8, rng() % 4), time + 1 + rng() % 4, 1.0 + rng() % 10);
+  }
+
+  auto ask_phase(uat::uint_t, uat::ask_fn ask, uat::permit_public_status_fn, int seed) -> void override
+  {
+    std::mt19937 rng(static_cast<unsigned>(seed));
+    for (const auto& [v, t] : owned_)
+      if (rng() % 2)
+        ask(v, t, 0.5);
+    owned_.clear();
+  }
+
+  auto on_bought(const voxel& v, uat::uint_t time, uat::value_t) -> void override { owned_.emplace_back(v, time); }
+
+  auto stop(uat::uint_t time, int) -> bool override { return time > 30; }
+
+private:
+  std::vector<std::pair<voxel, uat::uint_t>> owned_;
+};
+
+//! Query without key ranges, which makes the simulation test every permit.
+struct everything
+{
+  auto contains(const voxel&) const -> bool { return true; }
+};
+
+} // namespace
+
+static_assert(uat::ordered_region_query<uat::voxel_box, voxel>);
+static_assert(!uat::ordered_region_query<everything, voxel>);
+
+TEST_CASE("voxels round-trip their coordinates", "[voxel]")
+{
+  std::mt19937 rng(1);
+  for (int i = 0; i < 1000; ++i) {
+    const auto x = rng() & voxel::max_coordinate, y = rng() & voxel::max_coordinate, z = rng() & voxel::max_coordinate;
+    const voxel v(x, y, z);
+    CHECK(v.x() == x);
+    CHECK(v.y() == y);
+    CHECK(v.z() == z);
+    CHECK(voxel::from_key(v.key()) == v);
+  }
+  CHECK(voxel(1, 0, 0).key() == 1);
+  CHECK(voxel(0, 1, 0).key() == 2);
+  CHECK(voxel(0, 0, 1).key() == 4);
+}
+
+TEST_CASE("next_in_box finds the next key inside the box", "[voxel]")
+{
+  std::mt19937 rng(2);
+  int checked = 0;
+  for (int i = 0; i < 300; ++i) {
+    const auto box = random_box(rng);
+    for (auto key = box.min.key(); key <= box.max.key(); ++key) {
+      if (box.contains(voxel::from_key(key)))
+        continue;
+      auto expected = key + 1;
+      while (!box.contains(voxel::from_key(expected)))
+        ++expected;
+      CHECK(uat::morton::next_in_box(key, box.min.key(), box.max.key()) == expected);
+      ++checked;
+    }
+  }
+  CHECK(checked > 1000);
+}
+
+TEST_CASE("box queries visit the same permits as a full scan", "[voxel]")
+{
+  uat::simulation<voxel> sim({
+    .factory = [](uat::uint_t t, int) {
+      std::vector<uat::any_agent> agents;
+      if (t < 20)
+        for (int i = 0; i < 6; ++i)
+          agents.push_back(flyer{});
+      return agents;
+    },
+    .seed = 3,
+  });
+
+  using entry_t = std::tuple<uat::uint_t, std::uint64_t, std::size_t>;
+  std::mt19937 rng(4);
+  std::size_t visited = 0;
+  while (!sim.finished()) {
+    sim.step();
+    for (int i = 0; i < 10; ++i) {
+      const auto box = random_box(rng);
+      std::vector<entry_t> fast, slow;
+      sim.query(box, sim.time(), sim.time() + 5, [&](const voxel& v, uat::uint_t t, const uat::permit_private_status_t& status) {
+        CHECK(box.contains(v));
+        fast.emplace_back(t, v.key(), status.history.size());
+      });
+      sim.query(everything{}, sim.time(), sim.time() + 5,
+                [&](const voxel& v, uat::uint_t t, const uat::permit_private_status_t& status) {
+                  if (box.contains(v))
+                    slow.emplace_back(t, v.key(), status.history.size());
+                });
+      std::ranges::sort(slow);
+      CHECK(fast.size() == slow.size());
+      CHECK(fast == slow); // Ordered buckets are visited by time and key.
+      visited += fast.size();
+    }
+  }
+  CHECK(visited > 0);
+}